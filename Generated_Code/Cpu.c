@@ -337,6 +337,7 @@
 #include "INT_PIT0.h"
 #include "INT_FTM0.h"
 #include "INT_I2C0.h"
+#include "INT_DMA0.h"
 #include "INT_PORTB.h"
 #include "INT_SysTick.h"
 #include "INT_PendableSrvReq.h"
@@ -549,21 +550,6 @@ PE_ISR(Cpu_ivINT_Reserved13)
   PE_DEBUGHALT();
 }
 
-/*
-** ===================================================================
-**     Method      :  Cpu_Cpu_ivINT_DMA0_DMA16 (component MK70FN1M0MJ15)
-**
-**     Description :
-**         This ISR services an unused interrupt/exception vector.
-**         This method is internal. It is used by Processor Expert only.
-** ===================================================================
-*/
-PE_ISR(Cpu_ivINT_DMA0_DMA16)
-{
-  /* This code can be changed using the CPU component property "Build Options / Unhandled int code" */
-  PE_DEBUGHALT();
-}
-
 /*
 ** ===================================================================
 **     Method      :  Cpu_Cpu_ivINT_DMA1_DMA17 (component MK70FN1M0MJ15)
@@ -2197,6 +2183,8 @@ void PE_low_level_init(void)
   NVICIP62 = NVIC_IP_PRI62(0x80);
   /* NVICIP24: PRI24=0x80 */
   NVICIP24 = NVIC_IP_PRI24(0x80);
+  /* NVICIP0: PRI0=0x80 */
+  NVICIP0 = NVIC_IP_PRI0(0x80);
   /* NVICIP88: PRI88=0x80 */
   NVICIP88 = NVIC_IP_PRI88(0x80);
   /* NVICIP91: PRI91=0x80 */
@@ -2211,8 +2199,8 @@ void PE_low_level_init(void)
   NVICISER1 |= NVIC_ISER_SETENA(0x40020000);
   /* NVICISER2: SETENA|=0x0D080018 */
   NVICISER2 |= NVIC_ISER_SETENA(0x0D080018);
-  /* NVICISER0: SETENA|=0x01000000 */
-  NVICISER0 |= NVIC_ISER_SETENA(0x01000000);
+  /* NVICISER0: SETENA|=0x01000001 */
+  NVICISER0 |= NVIC_ISER_SETENA(0x01000001);
   /* SCB_SHPR3: PRI_15=0x80,PRI_14=0x80 */
   SCB_SHPR3 = (uint32_t)((SCB_SHPR3 & (uint32_t)~(uint32_t)(
                SCB_SHPR3_PRI_15(0x7F) |
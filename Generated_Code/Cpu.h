@@ -292,17 +292,6 @@ PE_ISR(Cpu_ivINT_Reserved13);
 ** ===================================================================
 */
 
-PE_ISR(Cpu_ivINT_DMA0_DMA16);
-/*
-** ===================================================================
-**     Method      :  Cpu_Cpu_ivINT_DMA0_DMA16 (component MK70FN1M0MJ15)
-**
-**     Description :
-**         This ISR services an unused interrupt/exception vector.
-**         This method is internal. It is used by Processor Expert only.
-** ===================================================================
-*/
-
 PE_ISR(Cpu_ivINT_DMA1_DMA17);
 /*
 ** ===================================================================
@@ -66,6 +66,7 @@
 #include "INT_PIT0.h"
 #include "INT_FTM0.h"
 #include "INT_I2C0.h"
+#include "INT_DMA0.h"
 #include "INT_PORTB.h"
 #include "INT_SysTick.h"
 #include "INT_PendableSrvReq.h"
@@ -60,6 +60,7 @@
   #include "INT_PIT0.h"
   #include "INT_FTM0.h"
   #include "INT_I2C0.h"
+  #include "INT_DMA0.h"
   #include "INT_PORTB.h"
   #include "INT_SysTick.h"
   #include "INT_PendableSrvReq.h"
@@ -101,7 +102,7 @@
     (tIsrFunc)&Cpu_ivINT_Reserved13,   /* 0x0D  0x00000034   -   ivINT_Reserved13               unused by PE */
     (tIsrFunc)&ContextSwitch,          /* 0x0E  0x00000038   8   ivINT_PendableSrvReq           used by PE */
     (tIsrFunc)&SysTickISR,             /* 0x0F  0x0000003C   8   ivINT_SysTick                  used by PE */
-    (tIsrFunc)&Cpu_ivINT_DMA0_DMA16,   /* 0x10  0x00000040   -   ivINT_DMA0_DMA16               unused by PE */
+    (tIsrFunc)&I2C_DMA_ISR,            /* 0x10  0x00000040   8   ivINT_DMA0_DMA16               used by PE */
     (tIsrFunc)&Cpu_ivINT_DMA1_DMA17,   /* 0x11  0x00000044   -   ivINT_DMA1_DMA17               unused by PE */
     (tIsrFunc)&Cpu_ivINT_DMA2_DMA18,   /* 0x12  0x00000048   -   ivINT_DMA2_DMA18               unused by PE */
     (tIsrFunc)&Cpu_ivINT_DMA3_DMA19,   /* 0x13  0x0000004C   -   ivINT_DMA3_DMA19               unused by PE */
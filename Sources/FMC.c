@@ -0,0 +1,117 @@
+/*! @file
+ *
+ *  @brief Implementation of the Flash memory controller (FMC) configuration.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-08
+ */
+/*!
+**  @addtogroup fmc_module FMC module documentation
+**  @{
+*/
+#include "FMC.h"
+
+#include "ramfunc.h"
+
+#include "Cpu.h"
+#include "MK70F12.h"
+#include "FMC_PDD.h"
+
+/*!
+ * @brief All the per-master prefetch disable bits in PFAPR.
+ */
+#define PFAPR_PFD_MASK (0xFFLU << FMC_PFAPR_M0PFD_SHIFT)
+
+/*!
+ * @brief Speculation bits which exist for both block pairs, in the PFB01CR positions.
+ */
+#define PFB_SPECULATION_MASK (FMC_PFB01CR_B01SEBE_MASK | FMC_PFB01CR_B01IPE_MASK | FMC_PFB01CR_B01DPE_MASK)
+
+/*!
+ * @brief Cache bits, these only exist in PFB01CR.
+ */
+#define PFB_CACHE_MASK (FMC_PFB01CR_B01ICE_MASK | FMC_PFB01CR_B01DCE_MASK | FMC_PFB01CR_CRC_MASK)
+
+/*!
+ * @brief Write the control registers.
+ *
+ * Runs from RAM with interrupts off, so no fetch goes through the FMC while it changes.
+ * @param pfapr The new PFAPR value.
+ * @param speculation The speculation bits for both block pairs.
+ * @param cache The cache bits.
+ */
+static RAMFUNC void WriteControl(const uint32_t pfapr, const uint32_t speculation, const uint32_t cache)
+{
+	EnterCritical();
+	FMC_PDD_WriteFlashAccessProtectionReg(FMC_BASE_PTR, pfapr);
+	FMC_PFB01CR = (FMC_PFB01CR & ~(PFB_SPECULATION_MASK | PFB_CACHE_MASK)) | speculation | cache;
+	//PFB23CR has the same layout for the speculation bits
+	FMC_PFB23CR = (FMC_PFB23CR & ~PFB_SPECULATION_MASK) | speculation;
+	FMC_PDD_InvalidateFlashCache(FMC_BASE_PTR);
+	ExitCritical();
+}
+
+BOOL FMC_Set(const TFMCSetup * const setup)
+{
+	if (setup->cacheWays != FMC_CACHE_WAYS_SHARED
+			&& setup->cacheWays != FMC_CACHE_WAYS_IFETCH_2_DATA_2
+			&& setup->cacheWays != FMC_CACHE_WAYS_IFETCH_3_DATA_1)
+	{
+		return bFALSE;
+	}
+
+	//A set bit disables prefetching for that master
+	uint32_t pfapr = FMC_PDD_ReadFlashAccessProtectionReg(FMC_BASE_PTR);
+	pfapr |= PFAPR_PFD_MASK;
+	pfapr &= ~((uint32_t) setup->masterPrefetch << FMC_PFAPR_M0PFD_SHIFT);
+
+	uint32_t speculation = 0;
+	if (setup->singleEntryBuffer)
+	{
+		speculation |= FMC_PFB01CR_B01SEBE_MASK;
+	}
+	if (setup->instructionSpeculation)
+	{
+		speculation |= FMC_PFB01CR_B01IPE_MASK;
+	}
+	if (setup->dataSpeculation)
+	{
+		speculation |= FMC_PFB01CR_B01DPE_MASK;
+	}
+
+	uint32_t cache = FMC_PFB01CR_CRC(setup->cacheWays);
+	if (setup->instructionCache)
+	{
+		cache |= FMC_PFB01CR_B01ICE_MASK;
+	}
+	if (setup->dataCache)
+	{
+		cache |= FMC_PFB01CR_B01DCE_MASK;
+	}
+
+	WriteControl(pfapr, speculation, cache);
+	return bTRUE;
+}
+
+void FMC_Get(TFMCSetup * const setup)
+{
+	uint32_t pfapr = FMC_PDD_ReadFlashAccessProtectionReg(FMC_BASE_PTR);
+	uint32_t pfb01cr = FMC_PFB01CR;
+
+	setup->masterPrefetch = (uint8_t) ~((pfapr & PFAPR_PFD_MASK) >> FMC_PFAPR_M0PFD_SHIFT);
+	setup->singleEntryBuffer = (pfb01cr & FMC_PFB01CR_B01SEBE_MASK) ? bTRUE : bFALSE;
+	setup->instructionSpeculation = (pfb01cr & FMC_PFB01CR_B01IPE_MASK) ? bTRUE : bFALSE;
+	setup->dataSpeculation = (pfb01cr & FMC_PFB01CR_B01DPE_MASK) ? bTRUE : bFALSE;
+	setup->instructionCache = (pfb01cr & FMC_PFB01CR_B01ICE_MASK) ? bTRUE : bFALSE;
+	setup->dataCache = (pfb01cr & FMC_PFB01CR_B01DCE_MASK) ? bTRUE : bFALSE;
+	setup->cacheWays = (TFMCCacheWays) ((pfb01cr & FMC_PFB01CR_CRC_MASK) >> FMC_PFB01CR_CRC_SHIFT);
+}
+
+void FMC_InvalidateCache(void)
+{
+	FMC_PDD_InvalidateFlashCache(FMC_BASE_PTR);
+}
+
+/*!
+** @}
+*/
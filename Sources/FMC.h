@@ -0,0 +1,86 @@
+/*! @file
+ *
+ *  @brief Routines for configuring the Flash memory controller (FMC).
+ *
+ *  This contains the functions for setting the prefetch, speculation and cache
+ *  behaviour of the program Flash, and for keeping the cache coherent after Flash writes.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-08
+ */
+/*!
+**  @addtogroup fmc_module FMC module documentation
+**  @{
+*/
+#ifndef FMC_H
+#define FMC_H
+
+// new types
+#include "types.h"
+
+/*!
+ * @brief Crossbar masters which can read the program Flash.
+ */
+typedef enum
+{
+  FMC_MASTER_CORE_CODE = 0,
+  FMC_MASTER_CORE_SYSTEM = 1,
+  FMC_MASTER_DMA = 2,
+  FMC_MASTER_ENET = 3,
+  FMC_MASTER_USB_FS = 4,
+  FMC_MASTER_SDHC = 5,
+  FMC_MASTER_NFC = 6,
+  FMC_MASTER_USB_HS = 7
+} TFMCMaster;
+
+/*!
+ * @brief How the 4 cache ways are shared between instruction fetches and data.
+ */
+typedef enum
+{
+  FMC_CACHE_WAYS_SHARED = 0x0,       /*!< LRU across all 4 ways */
+  FMC_CACHE_WAYS_IFETCH_2_DATA_2 = 0x2, /*!< Ways 0-1 for instruction fetches, 2-3 for data */
+  FMC_CACHE_WAYS_IFETCH_3_DATA_1 = 0x3  /*!< Ways 0-2 for instruction fetches, 3 for data */
+} TFMCCacheWays;
+
+/*!
+ * @brief An FMC configuration, applied with FMC_Set and read back with FMC_Get.
+ */
+typedef struct
+{
+  uint8_t masterPrefetch;       /*!< Bit n enables prefetching for master n (TFMCMaster). */
+  BOOL singleEntryBuffer;       /*!< Enables the single entry speculation buffer. */
+  BOOL instructionSpeculation;  /*!< Speculatively fetch the next instruction line. */
+  BOOL dataSpeculation;         /*!< Speculatively fetch the next data line. */
+  BOOL instructionCache;        /*!< Cache instruction fetches. */
+  BOOL dataCache;               /*!< Cache data reads. */
+  TFMCCacheWays cacheWays;      /*!< Allocation of the cache ways. */
+} TFMCSetup;
+
+/*! @brief Applies an FMC configuration.
+ *
+ *  The speculation settings are applied to both program Flash blocks.
+ *  @param setup is a pointer to the configuration.
+ *  @return BOOL - TRUE if the configuration was applied.
+ *  @note The cache is invalidated as part of the change.
+ */
+BOOL FMC_Set(const TFMCSetup * const setup);
+
+/*! @brief Reads back the current FMC configuration.
+ *
+ *  @param setup is filled with the configuration.
+ */
+void FMC_Get(TFMCSetup * const setup);
+
+/*! @brief Invalidates the Flash cache and the speculation buffers.
+ *
+ *  Must be called after the Flash has been erased or programmed,
+ *  otherwise reads can return the old contents.
+ */
+void FMC_InvalidateCache(void);
+
+#endif
+
+/*!
+** @}
+*/
@@ -12,6 +12,8 @@
 #include "types.h"
 #include "Flash.h"
 #include "MK70F12.h"
+#include "FMC.h"
+#include "ramfunc.h"
 
 #include <string.h>
 
@@ -35,10 +37,17 @@ static uint8_t AllocationMap[FLASH_DATA_SIZE] = { FLASH_EMPTY };
 
 #define FLASH_CMD_PGM8 0x07LU
 
+//Swap Control
+#define FLASH_CMD_SWAP 0x46LU
+
+//Errors left by a command
+#define FLASH_ERROR_MASK (FTFE_FSTAT_ACCERR_MASK | FTFE_FSTAT_FPVIOL_MASK | FTFE_FSTAT_MGSTAT0_MASK)
+
 /* @brief Wait for the CCIF register to be set to 1.
  *
+ * Runs from RAM, as fetching the loop from Flash stalls while a command is in progress.
  */
-void WaitCCIFReady()
+RAMFUNC void WaitCCIFReady()
 {
 	while (!(FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK))
 		;
@@ -47,11 +56,14 @@ void WaitCCIFReady()
 /*! @brief Set CCIF and the wait for it to be set.
  * Used to start a flash command and wait for it to complete
  *
+ * Runs from RAM, interrupts are left enabled for the duration of the command.
+ * The Flash cache is invalidated so reads see the new contents.
  */
-void SetCCIFAndWait()
+RAMFUNC void SetCCIFAndWait()
 {
 	FTFE_FSTAT |= FTFE_FSTAT_CCIF_MASK;
 	WaitCCIFReady();
+	FMC_InvalidateCache();
 }
 
 BOOL MGSTAT0Error()
@@ -88,6 +100,34 @@ BOOL HandleErrorRegisters()
 	return bTRUE;
 }
 
+/*!
+ * @brief Clear the error flags and load the command and address into FCCOB0..3.
+ * @param command The Flash command.
+ * @param address The address the command operates on.
+ */
+static void LoadCommand(const uint8_t command, const uint32_t address)
+{
+	uint32_8union_t flashAddress;
+	flashAddress.l = address;
+
+	//Errors from a previous command block a new one being launched
+	FTFE_FSTAT = FTFE_FSTAT_ACCERR_MASK | FTFE_FSTAT_FPVIOL_MASK;
+
+	FTFE_FCCOB0 = command;
+	FTFE_FCCOB1 = flashAddress.s.b;
+	FTFE_FCCOB2 = flashAddress.s.c;
+	FTFE_FCCOB3 = flashAddress.s.d;
+}
+
+/*!
+ * @brief Check the result of the last command.
+ * @return bTRUE if it completed without error.
+ */
+static BOOL CommandSucceeded()
+{
+	return !(FTFE_FSTAT & FLASH_ERROR_MASK);
+}
+
 /*! @brief Initializes the flash modules.
  *
  *  @return BOOL - TRUE if the Flash was setup successfully.
@@ -312,6 +352,77 @@ BOOL Flash_Erase(void)
 	return HandleErrorRegisters();
 }
 
+BOOL Flash_EraseSector(const uint32_t address, const BOOL waitCompletion)
+{
+	WaitCCIFReady();
+	LoadCommand(FLASH_CMD_ERSSCR, address & ~(FLASH_SECTOR_SIZE - 1));
+	if (!waitCompletion)
+	{
+		//Launch and let it run in the background
+		FTFE_FSTAT = FTFE_FSTAT_CCIF_MASK;
+		return bTRUE;
+	}
+	SetCCIFAndWait();
+	return CommandSucceeded();
+}
+
+BOOL Flash_ProgramPhrase(const uint32_t address, const uint8_t data[8], const BOOL waitCompletion)
+{
+	if (address & 0x7)
+	{
+		//not aligned
+		return bFALSE;
+	}
+
+	//Let the previous phrase finish, and make sure it did
+	WaitCCIFReady();
+	if (!CommandSucceeded())
+	{
+		return bFALSE;
+	}
+
+	LoadCommand(FLASH_CMD_PGM8, address);
+
+	//Same byte order as WritePhrase
+	FTFE_FCCOB4 = data[3];
+	FTFE_FCCOB5 = data[2];
+	FTFE_FCCOB6 = data[1];
+	FTFE_FCCOB7 = data[0];
+	FTFE_FCCOB8 = data[7];
+	FTFE_FCCOB9 = data[6];
+	FTFE_FCCOBA = data[5];
+	FTFE_FCCOBB = data[4];
+
+	if (!waitCompletion)
+	{
+		//Launch and let it run in the background
+		FTFE_FSTAT = FTFE_FSTAT_CCIF_MASK;
+		return bTRUE;
+	}
+	SetCCIFAndWait();
+	return CommandSucceeded();
+}
+
+BOOL Flash_Wait()
+{
+	WaitCCIFReady();
+	FMC_InvalidateCache();
+	return CommandSucceeded();
+}
+
+BOOL Flash_SwapControl(const TFlashSwapControl control, TFlashSwapMode * const mode)
+{
+	WaitCCIFReady();
+	LoadCommand(FLASH_CMD_SWAP, FLASH_SWAP_INDICATOR_OFFSET);
+	FTFE_FCCOB4 = control;
+	SetCCIFAndWait();
+	if (mode)
+	{
+		*mode = (TFlashSwapMode) FTFE_FCCOB5;
+	}
+	return CommandSucceeded();
+}
+
 /*!
 ** @}
 */
@@ -23,13 +23,47 @@
 #define _FW(flashAddress)  *(uint32_t volatile *)(flashAddress)//Longword 32bit
 #define _FP(flashAddress)  *(uint64_t volatile *)(flashAddress)//Phrase 64bit
 
+// Size of each of the two program Flash blocks
+#define FLASH_BLOCK_SIZE 0x00080000LU
+// Address of the program Flash block which is not being executed from (after any swap)
+#define FLASH_INACTIVE_BLOCK_START 0x00080000LU
+// Size of the smallest erasable unit
+#define FLASH_SECTOR_SIZE 0x00001000LU
+// Offset of the swap indicator sector within each block (the last sector)
+#define FLASH_SWAP_INDICATOR_OFFSET (FLASH_BLOCK_SIZE - FLASH_SECTOR_SIZE)
+// Offset of the data sector within each block (the sector below the swap indicator)
+#define FLASH_DATA_OFFSET (FLASH_SWAP_INDICATOR_OFFSET - FLASH_SECTOR_SIZE)
+
 // Address of the start (0) of the Flash block we are using for data storage
-#define FLASH_DATA_START 0x00080000LU
+#define FLASH_DATA_START (FLASH_INACTIVE_BLOCK_START + FLASH_DATA_OFFSET)
 // Address of the end of the Flash block we are using for data storage
-#define FLASH_DATA_END   0x00080007LU
+#define FLASH_DATA_END   (FLASH_DATA_START + 7LU)
 // The number of bytes in the flash block (currently 8)
 #define FLASH_DATA_SIZE ((FLASH_DATA_END-FLASH_DATA_START)+1)
 
+/*!
+ * @brief States of the program Flash swap system.
+ */
+typedef enum
+{
+  FLASH_SWAP_UNINITIALIZED = 0x00,
+  FLASH_SWAP_READY = 0x01,
+  FLASH_SWAP_UPDATE = 0x02,
+  FLASH_SWAP_UPDATE_ERASED = 0x03,
+  FLASH_SWAP_COMPLETE = 0x04
+} TFlashSwapMode;
+
+/*!
+ * @brief Swap control codes.
+ */
+typedef enum
+{
+  FLASH_SWAP_CONTROL_INITIALIZE = 0x01,
+  FLASH_SWAP_CONTROL_SET_UPDATE = 0x02,
+  FLASH_SWAP_CONTROL_SET_COMPLETE = 0x04,
+  FLASH_SWAP_CONTROL_REPORT = 0x08
+} TFlashSwapControl;
+
 /*! @brief Enables the Flash module.
  *
  *  @return BOOL - TRUE if the Flash was setup successfully.
@@ -85,6 +119,40 @@ BOOL Flash_Write8(volatile uint8_t* const address, const uint8_t data);
  */
 BOOL Flash_Erase();
 
+/*! @brief Erases one sector of program Flash.
+ *
+ *  @param address Any address within the sector.
+ *  @param waitCompletion Should wait to return until the operation completes.
+ *         Otherwise the command keeps running in the background and the next Flash command waits for it.
+ *  @return BOOL - TRUE if the command was accepted (and the sector was erased successfully when waiting).
+ *  @note If the sector is in the block being executed from, interrupts must be disabled (only the wait runs from RAM).
+ */
+BOOL Flash_EraseSector(const uint32_t address, const BOOL waitCompletion);
+
+/*! @brief Programs a phrase (8 bytes) of program Flash.
+ *
+ *  @param address The address to program, must be aligned to 8 bytes and already erased.
+ *  @param data The 8 bytes to program, data[0] goes to the lowest address.
+ *  @param waitCompletion Should wait to return until the operation completes.
+ *         Otherwise the command keeps running in the background and the next Flash command waits for it.
+ *  @return BOOL - TRUE if the command was accepted (and completed without error when waiting).
+ */
+BOOL Flash_ProgramPhrase(const uint32_t address, const uint8_t data[8], const BOOL waitCompletion);
+
+/*! @brief Waits for a Flash command started in the background.
+ *
+ *  @return BOOL - TRUE if the last command completed without error.
+ */
+BOOL Flash_Wait();
+
+/*! @brief Runs a swap control command.
+ *
+ *  @param control The swap control code.
+ *  @param mode Set to the swap mode reported after the command, may be NULL.
+ *  @return BOOL - TRUE if the command completed without error.
+ */
+BOOL Flash_SwapControl(const TFlashSwapControl control, TFlashSwapMode * const mode);
+
 /*!
 ** @}
 */
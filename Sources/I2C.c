@@ -13,6 +13,7 @@
 */
 #include "I2C.h"
 
+#include "bench.h"
 #include "OS.h"
 
 #include "MK70F12.h"
@@ -29,12 +30,14 @@
 #define I2C_D_WRITE(x) (((uint8_t)(((uint8_t)(x))<<1))|0x00)
 
 /*!
- * @brief Direction of communication for current transmission.
+ * @brief eDMA channel used for received payloads.
  */
-typedef enum
-{
-	I2C_READ = 0, I2C_WRITE = 1
-} TI2CCommDirection;
+#define I2C_DMA_CHANNEL 0
+
+/*!
+ * @brief DMAMUX0 request source of I2C0.
+ */
+#define I2C_DMA_SOURCE 22
 
 /*!
  * @brief Possible module status.
@@ -49,11 +52,6 @@ typedef enum
  */
 TI2CStatus Status;
 
-/*!
- * @brief Current communication direction
- */
-static TI2CCommDirection CommunicationDirection;
-
 /*!
  * @brief Position in the I2C transmission.
  * 0 - Send device address (write)
@@ -61,47 +59,69 @@ static TI2CCommDirection CommunicationDirection;
  * IF READ
  * 1.5  - send repeated start if read
  * 2 - send device address (read)
- * 3...(n-1) - read data and ak.
- * n - read data and nak. STOP
+ * 3 - switch to receive
+ * 4 - read data, ak until the second last, nak the last.
  * IF WRITE
- * 2...n - send data. STOP
+ * 2 - send data
+ * 3 - done
+ * When done the next queued transaction is started with a repeated start, otherwise STOP.
  */
 static uint8_t Position = 0;
 
 /*!
- * @brief Address of slave to communicate with.
+ * @brief The module clock, for working out device speeds.
  */
-static uint8_t SlaveAddress;
+static uint32_t ModuleClock;
 
 /*!
- * @brief Register to read / write from.
+ * @brief The queued transactions, the one at QueueHead is on the bus.
  */
-static uint8_t RegisterAddress;
+static TI2CTransaction Queue[I2C_QUEUE_SIZE];
 
 /*!
- * @brief Copy of byte to write.
+ * @brief Index of the oldest transaction.
  */
-static uint8_t WriteByteCopy;
+static uint8_t QueueHead;
 
 /*!
- * @brief Destination to write data.
+ * @brief Number of transactions in the queue.
  */
-static uint8_t *ReadDestination;
+static uint8_t QueueCount;
 
 /*!
- * @brief Pointer to last byte of destination.
+ * @brief How reads of at least I2C_DMA_MIN_BYTES are received.
  */
-static uint8_t *ReadDestinationEnd;
+static TI2CReceiveMode ReceiveMode = I2C_RECEIVE_DMA;
+
+/*!
+ * @brief Interrupt count and cycles, for I2C_GetStatistics.
+ */
+static TI2CStatistics Statistics;
+
+/*!
+ * @brief Semaphores lent to blocked threads.
+ */
+static OS_ECB *BlockingSemaphores[I2C_BLOCKING_COUNT];
+
+/*!
+ * @brief Bit n is set while BlockingSemaphores[n] is lent out.
+ */
+static uint8_t BlockingInUse;
+
+/*!
+ * @brief Destination of the next byte read.
+ */
+static uint8_t *ReadDestination;
 
 /*!
- * @brief Callback once current operation completes.
+ * @brief Pointer to last byte of destination.
  */
-static void (*CallbackFunction)(void*);
+static uint8_t *ReadDestinationEnd;
 
 /*!
- * @brief Argument passed to callback.
+ * @brief Bit times CommenceTransmission waits for the bus to be freed by a STOP.
  */
-static void *CallbackArguments;
+#define I2C_IDLE_WAIT_BITS 4
 
 /*!
  * @brief Tolerance of the baud rate search.
@@ -133,12 +153,12 @@ const static uint16_t scl[] = { 20, 22, 24, 26, 28, 30, 34, 40, 28, 32, 36, 40,
 		2048, 2304, 2560, 3072, 3840 };
 
 /*!
- * @brief Set the I2C baud rate.
+ * @brief Find the frequency divider register value for a baud rate.
  * @param baudRate The target baud rate.
- * @param moduleClk The module clock.
+ * @param divider Set to the I2C0_F value.
  * @return BOOL if successful or not.
  */
-BOOL BaudRate(uint32_t baudRate, uint32_t moduleClk)
+static BOOL FindDivider(const uint32_t baudRate, uint8_t * const divider)
 {
 	uint32_t baudResult;
 	const uint32_t lowerBaud = baudRate - BAUD_SEARCH_TOLERANCE;
@@ -147,11 +167,10 @@ BOOL BaudRate(uint32_t baudRate, uint32_t moduleClk)
 	{
 		for (int j = 0; j < multiplierSize; j++)
 		{
-			baudResult = (moduleClk / (multiplier[j] * scl[i]));
+			baudResult = (ModuleClock / (multiplier[j] * scl[i]));
 			if (lowerBaud < baudResult && baudResult < upperBaud)
 			{
-				I2C0_F |= I2C_F_ICR(i);
-				I2C0_F |= I2C_F_MULT(j);
+				*divider = I2C_F_ICR(i) | I2C_F_MULT(j);
 				return bTRUE;
 			}
 		}
@@ -178,11 +197,35 @@ BOOL I2C_Init(const uint32_t baudRate, const uint32_t moduleClk)
 	NVICIP24 = NVIC_IP_PRI24(0x80);
 	NVICISER0 |= NVIC_ISER_SETENA(0x01000000);
 
-	if (!BaudRate(baudRate, moduleClk))
+	//eDMA channel for the payload of long reads, byte from I2C0_D per request
+	SIM_SCGC6 |= SIM_SCGC6_DMAMUX0_MASK;
+	SIM_SCGC7 |= SIM_SCGC7_DMA_MASK;
+	DMAMUX0_CHCFG0 = 0;
+	DMA_TCD0_SADDR = (uint32_t) &I2C0_D;
+	DMA_TCD0_SOFF = 0;
+	DMA_TCD0_ATTR = DMA_ATTR_SSIZE(0) | DMA_ATTR_DSIZE(0);
+	DMA_TCD0_NBYTES_MLNO = DMA_NBYTES_MLNO_NBYTES(1);
+	DMA_TCD0_SLAST = 0;
+	DMA_TCD0_DOFF = 1;
+	DMA_TCD0_DLASTSGA = 0;
+	DMA_TCD0_CSR = DMA_CSR_DREQ_MASK | DMA_CSR_INTMAJOR_MASK;
+	DMAMUX0_CHCFG0 = DMAMUX_CHCFG_ENBL_MASK | DMAMUX_CHCFG_SOURCE(I2C_DMA_SOURCE);
+	NVICIP0 = NVIC_IP_PRI0(0x80);
+	NVICISER0 |= NVIC_ISER_SETENA(0x00000001);
+
+	ModuleClock = moduleClk;
+	uint8_t divider;
+	if (!FindDivider(baudRate, &divider))
 	{
 		PE_DEBUGHALT();
 		return bFALSE;
 	}
+	I2C0_F = divider;
+	for (size_t i = 0; i < I2C_BLOCKING_COUNT; i++)
+	{
+		BlockingSemaphores[i] = OS_SemaphoreCreate(0);
+	}
+
 // Enable i2c module
 	I2C0_C1 |= I2C_C1_IICEN_MASK;
 // Enable interrupt
@@ -190,39 +233,87 @@ BOOL I2C_Init(const uint32_t baudRate, const uint32_t moduleClk)
 	return bTRUE;
 }
 
-void I2C_SelectSlaveDevice(const uint8_t slaveAddress)
+BOOL I2C_DeviceInit(TI2CDevice * const device, const uint8_t slaveAddress, const uint32_t baudRate, const uint8_t retries)
 {
-	SlaveAddress = slaveAddress;
+	if (!FindDivider(baudRate, &device->frequencyDivider))
+	{
+		return bFALSE;
+	}
+	device->slaveAddress = slaveAddress;
+	device->retries = retries;
+	device->queued = 0;
+	return bTRUE;
+}
+
+/*!
+ * @brief Set up the pointers and bus speed for the transaction at the head of the queue.
+ */
+static void LoadHead()
+{
+	TI2CTransaction *transaction = &Queue[QueueHead];
+	ReadDestination = transaction->readDestination;
+	ReadDestinationEnd = transaction->readDestination + transaction->nbBytes;
+	Position = 1;
+	//Only touched when the device changes, SCL is held low between bytes
+	if (I2C0_F != transaction->device->frequencyDivider)
+	{
+		I2C0_F = transaction->device->frequencyDivider;
+	}
 }
 
 /*!
- * @brief Start a transmission on the I2C bus.
+ * @brief Start the transaction at the head of the queue with a repeated start.
  *
- * @param direction The direction of the communication.
- * @param registerAddress The address to read from on the I2C device.
- * @param data The data to write (if the direction is write).
- * @param destination An array with capacity nbBytes to store the bytes that are read.
- * @param nbBytes The number of bytes to read.
- * @param callback Callback after the operation completes.
- * @param callbackData Data for the callback.
+ * We must still own the bus.
  */
-BOOL CommenceTransmission(const TI2CCommDirection direction, const uint8_t registerAddress, const uint8_t data, uint8_t * const destination, const uint8_t nbBytes, void (*callback)(void*), void *callbackData)
+static void Restart()
 {
-	if ((Status == I2C_BUSY) | (I2C0_S & I2C_S_BUSY_MASK))
+	LoadHead();
+	I2C0_C1 |= I2C_C1_TX_MASK | I2C_C1_RSTA_MASK;
+	I2C0_C1 &= ~I2C_C1_TXAK_MASK;
+	I2C0_D = I2C_D_WRITE(Queue[QueueHead].device->slaveAddress);
+}
+
+/*!
+ * @brief Wait for the bus to be free.
+ *
+ * Right after we send a STOP the bus stays busy for up to a bit time.
+ * Each read of I2C0_S takes at least a module clock, so the wait is bounded
+ * to I2C_IDLE_WAIT_BITS bit times at the current speed.
+ * @return bTRUE if the bus is free.
+ */
+static BOOL WaitIdle()
+{
+	uint8_t divider = I2C0_F;
+	uint8_t mult = (divider & I2C_F_MULT_MASK) >> I2C_F_MULT_SHIFT;
+	uint32_t limit = I2C_IDLE_WAIT_BITS * multiplier[(mult < multiplierSize) ? mult : multiplierSize - 1] * scl[divider & I2C_F_ICR_MASK];
+	while (I2C0_S & I2C_S_BUSY_MASK)
 	{
+		if (limit-- == 0)
+		{
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Start the transaction at the head of the queue with a START.
+ *
+ * Must be called with interrupts disabled.
+ * @return bTRUE if the transaction is on the bus.
+ */
+BOOL CommenceTransmission()
+{
+	if (!WaitIdle())
+	{
+		//Held by another master, the next Kick starts it
+		Status = I2C_AVAILABLE;
 		return bFALSE;
 	}
 
-	//Only change globals if we have a lock.
 	Status = I2C_BUSY;
-
-	CommunicationDirection = direction;
-	RegisterAddress = registerAddress;
-	WriteByteCopy = data;
-	CallbackFunction = callback;
-	CallbackArguments = callbackData;
-	ReadDestination = destination;
-	ReadDestinationEnd = destination + nbBytes;
+	LoadHead();
 
 	//clear interrupt
 	I2C0_S |= I2C_S_IICIF_MASK;
@@ -240,70 +331,375 @@ BOOL CommenceTransmission(const TI2CCommDirection direction, const uint8_t regis
 		return bFALSE;
 	}
 
-	//Set to next position
-	Position = 1;
 	//send slave address (w) (first byte)
-	I2C0_D = I2C_D_WRITE(SlaveAddress);
+	I2C0_D = I2C_D_WRITE(Queue[QueueHead].device->slaveAddress);
+	return bTRUE;
+}
+
+/*!
+ * @brief Remove the cancelled transactions from the head of the queue without touching the bus.
+ *
+ * Must be called with interrupts disabled.
+ */
+static void DropCancelled()
+{
+	while (QueueCount && Queue[QueueHead].cancelled)
+	{
+		Queue[QueueHead].device->queued--;
+		QueueHead = (QueueHead + 1) % I2C_QUEUE_SIZE;
+		QueueCount--;
+	}
+}
+
+/*!
+ * @brief Remove the transaction at the head of the queue and notify its owner.
+ *
+ * The next transaction is started before the owner is notified, so the bus stays busy.
+ * @param success bTRUE if the transaction completed.
+ * @param restart bTRUE to start the next transaction with a repeated start, we still own the bus.
+ */
+static void Finish(const BOOL success, const BOOL restart)
+{
+	TI2CTransaction finished = Queue[QueueHead];
+	QueueHead = (QueueHead + 1) % I2C_QUEUE_SIZE;
+	QueueCount--;
+	finished.device->queued--;
+	DropCancelled();
+
+	if (QueueCount == 0)
+	{
+		if (restart)
+		{
+			//Only cancelled transactions were left, release the bus
+			I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_TXAK_MASK);
+		}
+		Status = I2C_AVAILABLE;
+	}
+	else if (restart)
+	{
+		Restart();
+	}
+	else
+	{
+		//Waits for our STOP to free the bus
+		(void) CommenceTransmission();
+	}
+
+	if (success && finished.callback)
+	{
+		(*finished.callback)(finished.callbackData);
+	}
+	else if (!success && finished.failed)
+	{
+		(*finished.failed)(finished.callbackData);
+	}
+	if (finished.result)
+	{
+		*finished.result = success ? I2C_DONE : I2C_FAILED;
+	}
+	if (finished.semaphore)
+	{
+		(void) OS_SemaphoreSignal(finished.semaphore);
+	}
+}
+
+/*!
+ * @brief Start the queue if nothing is on the bus.
+ *
+ * Covers the first transaction, and a bus which another master held past CommenceTransmission's wait.
+ */
+static void Kick()
+{
+	EnterCritical();
+	if ((Status != I2C_BUSY) && QueueCount)
+	{
+		(void) CommenceTransmission();
+	}
+	ExitCritical();
+}
+
+BOOL I2C_Submit(const TI2CTransaction * const transaction)
+{
+	TI2CDevice *device = transaction->device;
+	EnterCritical();
+	//A device may only hold part of the queue, so a busy one can't lock the others out
+	if ((QueueCount == I2C_QUEUE_SIZE) || (device->queued >= I2C_DEVICE_QUEUE_LIMIT))
+	{
+		ExitCritical();
+		return bFALSE;
+	}
+	TI2CTransaction *queued = &Queue[(QueueHead + QueueCount) % I2C_QUEUE_SIZE];
+	*queued = *transaction;
+	queued->retries = device->retries;
+	queued->cancelled = bFALSE;
+	device->queued++;
+	QueueCount++;
+	Kick();
+	ExitCritical();
 	return bTRUE;
 }
 
-void I2C_Write(const uint8_t registerAddress, const uint8_t data,
+/*!
+ * @brief Queue a transaction.
+ *
+ * @param device The device to address.
+ * @param direction The direction of the communication.
+ * @param registerAddress The address to read from on the I2C device.
+ * @param data The data to write (if the direction is write).
+ * @param destination An array with capacity nbBytes to store the bytes that are read.
+ * @param nbBytes The number of bytes to read.
+ * @param callback Callback after the operation completes.
+ * @param failed Callback if the operation fails.
+ * @param callbackData Data for the callbacks.
+ * @param semaphore Signalled once the transaction has finished.
+ * @param result Set once the transaction has finished.
+ * @return bTRUE if the transaction was queued.
+ */
+static BOOL QueueTransaction(TI2CDevice * const device, const TI2CCommDirection direction, const uint8_t registerAddress, const uint8_t data, uint8_t * const destination, const uint8_t nbBytes, void (*callback)(void*), void (*failed)(void*), void *callbackData, OS_ECB * const semaphore, volatile TI2CResult *result)
+{
+	TI2CTransaction transaction;
+	transaction.device = device;
+	transaction.registerAddress = registerAddress;
+	transaction.direction = direction;
+	transaction.writeData = data;
+	transaction.readDestination = destination;
+	transaction.nbBytes = nbBytes;
+	transaction.callback = callback;
+	transaction.failed = failed;
+	transaction.callbackData = callbackData;
+	transaction.semaphore = semaphore;
+	transaction.result = result;
+	return I2C_Submit(&transaction);
+}
+
+/*!
+ * @brief Handle an I2C error
+ */
+void Error()
+{
+	DMA_CERQ = DMA_CERQ_CERQ(I2C_DMA_CHANNEL);
+	I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_IICIE_MASK | I2C_C1_DMAEN_MASK); /* Generate STOP and disable further interrupts. */
+	Status = I2C_ERROR;
+	EnterCritical();
+	if (Queue[QueueHead].retries)
+	{
+		//Try again with a fresh START, once our STOP has freed the bus
+		Queue[QueueHead].retries--;
+		(void) CommenceTransmission();
+	}
+	else
+	{
+		//Drop the transaction, the rest are tried with a fresh START
+		Finish(bFALSE, bFALSE);
+	}
+	ExitCritical();
+}
+
+BOOL I2C_Write(TI2CDevice * const device, const uint8_t registerAddress, const uint8_t data,
 		const BOOL waitCompletion)
 {
-	BOOL free = bFALSE;
-	while (free == bFALSE)
+	volatile TI2CResult result = I2C_PENDING;
+	if (!QueueTransaction(device, I2C_WRITE, registerAddress, data, (void *) 0, 0, (void *) 0, (void *) 0, (void *) 0, (void *) 0, waitCompletion ? &result : (void *) 0))
 	{
-		free = CommenceTransmission(I2C_WRITE, registerAddress, data, (void *)0, 0, (void *) 0, (void *) 0);
+		return bFALSE;
 	}
 	if (waitCompletion)
 	{
-		//Need to wait for send to finish,
-		// as all the variables are pointing to the stack.
-		while (Status == I2C_BUSY)
+		while (result == I2C_PENDING)
 		{
+			Kick();
 		};
+		return (result == I2C_DONE);
 	}
+	return bTRUE;
 }
 
-void I2C_PollRead(const uint8_t registerAddress, uint8_t* const destination,
+BOOL I2C_PollRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination,
 		const uint8_t nbBytes)
 {
-	I2C_IntRead(registerAddress, destination, nbBytes, (void *) 0, (void *) 0);
-	while (Status == I2C_BUSY)
+	//Need to wait for the read to finish, the result is on the stack.
+	volatile TI2CResult result = I2C_PENDING;
+	if (!QueueTransaction(device, I2C_READ, registerAddress, 0, destination, nbBytes, (void *) 0, (void *) 0, (void *) 0, (void *) 0, &result))
 	{
+		return bFALSE;
+	}
+	while (result == I2C_PENDING)
+	{
+		Kick();
 	};
+	return (result == I2C_DONE);
+}
+
+BOOL I2C_IntRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination,
+		const uint8_t nbBytes, void (*callback)(void*), void (*failed)(void*), void *callbackData)
+{
+	return QueueTransaction(device, I2C_READ, registerAddress, 0, destination, nbBytes, callback, failed, callbackData, (void *) 0, (void *) 0);
 }
 
-void I2C_IntRead(const uint8_t registerAddress, uint8_t* const destination,
-		const uint8_t nbBytes, void (*callback)(void*), void *callbackData)
+/*!
+ * @brief Borrow a semaphore to block on.
+ * @return The index of the semaphore, or I2C_BLOCKING_COUNT if none are free.
+ */
+static uint8_t BorrowSemaphore()
 {
-	BOOL free = bFALSE;
-	while (free == bFALSE)
+	uint8_t index;
+	EnterCritical();
+	for (index = 0; index < I2C_BLOCKING_COUNT; index++)
 	{
-		free = CommenceTransmission(I2C_READ, registerAddress, 0, destination, nbBytes, callback, callbackData);
+		if (!(BlockingInUse & (1 << index)))
+		{
+			BlockingInUse |= (1 << index);
+			break;
+		}
 	}
+	ExitCritical();
+	return index;
 }
 
 /*!
- * @brief Handle an I2C error
+ * @brief Return a semaphore, it must not have a pending signal.
+ * @param index The index of the semaphore.
  */
-void Error()
+static void ReturnSemaphore(const uint8_t index)
 {
-	I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_IICIE_MASK); /* Generate STOP and disable further interrupts. */
-	Status = I2C_ERROR;
+	EnterCritical();
+	BlockingInUse &= ~(1 << index);
+	ExitCritical();
 }
 
 /*!
- * @brief Stop the I2C bus
+ * @brief Remove a timed out transaction from the queue.
+ *
+ * A queued transaction is dropped before it goes on the bus, one on the bus is aborted with a STOP.
+ * @param semaphore The semaphore of the transaction.
+ * @return bTRUE if it was removed, bFALSE if it had already finished (and signalled).
  */
-void Stop()
+static BOOL Cancel(OS_ECB * const semaphore)
 {
-	I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_IICIE_MASK | I2C_C1_TXAK_MASK);
-	Status = I2C_AVAILABLE;
-	if (CallbackFunction)
+	EnterCritical();
+	for (uint8_t i = 0; i < QueueCount; i++)
 	{
-		(*CallbackFunction)(CallbackArguments);
+		TI2CTransaction *transaction = &Queue[(QueueHead + i) % I2C_QUEUE_SIZE];
+		if (transaction->semaphore != semaphore)
+		{
+			continue;
+		}
+		//Nothing of the caller's may be touched after it returns
+		transaction->semaphore = (void *) 0;
+		transaction->result = (void *) 0;
+		transaction->callback = (void *) 0;
+		transaction->failed = (void *) 0;
+		transaction->retries = 0;
+		if ((i == 0) && (Status == I2C_BUSY))
+		{
+			I2C0_S |= I2C_S_IICIF_MASK;
+			Error();
+		}
+		else
+		{
+			transaction->cancelled = bTRUE;
+			if (i == 0)
+			{
+				//Waiting for the bus, start the next one instead
+				DropCancelled();
+				Kick();
+			}
+		}
+		ExitCritical();
+		return bTRUE;
 	}
+	ExitCritical();
+	return bFALSE;
+}
+
+/*!
+ * @brief Queue a transaction and sleep until it finishes.
+ *
+ * @param device The device to address.
+ * @param direction The direction of the communication.
+ * @param registerAddress The address to read from on the I2C device.
+ * @param data The data to write (if the direction is write).
+ * @param destination An array with capacity nbBytes to store the bytes that are read.
+ * @param nbBytes The number of bytes to read.
+ * @param timeout The maximum number of OS ticks to wait, 0 waits forever.
+ * @return bTRUE if the transaction succeeded.
+ */
+static BOOL BlockingTransaction(TI2CDevice * const device, const TI2CCommDirection direction, const uint8_t registerAddress, const uint8_t data, uint8_t * const destination, const uint8_t nbBytes, const uint16_t timeout)
+{
+	uint8_t index = BorrowSemaphore();
+	if (index == I2C_BLOCKING_COUNT)
+	{
+		return bFALSE;
+	}
+	OS_ECB *semaphore = BlockingSemaphores[index];
+
+	volatile TI2CResult result = I2C_PENDING;
+	if (!QueueTransaction(device, direction, registerAddress, data, destination, nbBytes, (void *) 0, (void *) 0, (void *) 0, semaphore, &result))
+	{
+		ReturnSemaphore(index);
+		return bFALSE;
+	}
+
+	if (OS_SemaphoreWait(semaphore, timeout) != OS_NO_ERROR)
+	{
+		if (Cancel(semaphore))
+		{
+			ReturnSemaphore(index);
+			return bFALSE;
+		}
+		//Finished between the timeout and the cancel, take the signal so the semaphore goes back clean
+		(void) OS_SemaphoreWait(semaphore, 0);
+	}
+	ReturnSemaphore(index);
+	return (result == I2C_DONE);
+}
+
+BOOL I2C_BlockingWrite(TI2CDevice * const device, const uint8_t registerAddress, const uint8_t data, const uint16_t timeout)
+{
+	return BlockingTransaction(device, I2C_WRITE, registerAddress, data, (void *) 0, 0, timeout);
+}
+
+BOOL I2C_BlockingRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes, const uint16_t timeout)
+{
+	return BlockingTransaction(device, I2C_READ, registerAddress, 0, destination, nbBytes, timeout);
+}
+
+/*!
+ * @brief Complete the transaction on the bus.
+ *
+ * The next transaction is started with a repeated start, if there are none we STOP.
+ * @param success bTRUE if the transaction completed.
+ */
+void Stop(const BOOL success)
+{
+	//A higher priority ISR could queue a transaction between the test and Finish
+	EnterCritical();
+	if (QueueCount == 1)
+	{
+		I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_TXAK_MASK);
+	}
+	Finish(success, bTRUE);
+	ExitCritical();
+}
+
+/*!
+ * @brief Handle a byte which wasn't acknowledged.
+ *
+ * The transaction is repeated while it has retries left, we still own the bus.
+ */
+static void Nak()
+{
+	EnterCritical();
+	if (Queue[QueueHead].retries)
+	{
+		Queue[QueueHead].retries--;
+		Restart();
+	}
+	else
+	{
+		Stop(bFALSE);
+	}
+	ExitCritical();
 }
 
 /*!
@@ -314,11 +710,43 @@ uint8_t RemainingReads()
 	return ReadDestinationEnd - ReadDestination;
 }
 
+void I2C_SetReceiveMode(const TI2CReceiveMode mode)
+{
+	ReceiveMode = mode;
+}
+
+void I2C_GetStatistics(TI2CStatistics * const statistics)
+{
+	EnterCritical();
+	*statistics = Statistics;
+	Statistics.interrupts = 0;
+	Statistics.cycles = 0;
+	ExitCritical();
+}
+
+/*!
+ * @brief Hand all but the last 2 bytes of the read to the eDMA.
+ *
+ * Called once the first byte has been started. The last 2 go back to the ISR,
+ * which has to NAK the last one.
+ */
+static void StartDMA()
+{
+	uint16_t count = RemainingReads() - 2;
+	DMA_TCD0_DADDR = (uint32_t) ReadDestination;
+	DMA_TCD0_CITER_ELINKNO = DMA_CITER_ELINKNO_CITER(count);
+	DMA_TCD0_BITER_ELINKNO = DMA_BITER_ELINKNO_BITER(count);
+	ReadDestination += count;
+	DMA_SERQ = DMA_SERQ_SERQ(I2C_DMA_CHANNEL);
+	//Byte complete now requests the eDMA instead of interrupting
+	I2C0_C1 = (I2C0_C1 & ~I2C_C1_IICIE_MASK) | I2C_C1_DMAEN_MASK;
+}
+
 void __attribute__ ((interrupt)) I2C_ISR(void)
 {
 	OS_ISREnter();
+	uint32_t start = BENCH_CYCLES();
 	//copy status register
-	uint16_t element;
 	uint8_t status = I2C0_S;
 	if (!(status & I2C_S_IICIF_MASK))
 	{
@@ -330,6 +758,13 @@ void __attribute__ ((interrupt)) I2C_ISR(void)
 	//acknowledge interrupt
 	I2C0_S |= I2C_S_IICIF_MASK;
 
+	//Left over from an aborted transaction
+	if (Status != I2C_BUSY)
+	{
+		OS_ISRExit();
+		return;
+	}
+
 	//TODO: arbitration loss test
 	if (status & I2C_S_ARBL_MASK)
 	{
@@ -339,23 +774,31 @@ void __attribute__ ((interrupt)) I2C_ISR(void)
 		return;
 	}
 
-	if (CommunicationDirection == I2C_WRITE)
+	//Slave address, register or data not acknowledged
+	if ((I2C0_C1 & I2C_C1_TX_MASK) && (status & I2C_S_RXAK_MASK))
+	{
+		Nak();
+		OS_ISRExit();
+		return;
+	}
+
+	TI2CTransaction *transaction = &Queue[QueueHead];
+	if (transaction->direction == I2C_WRITE)
 	{
 		switch (Position)
 		{
 		case 0:
 		case 1:
 			//send register address
-			I2C0_D = RegisterAddress;
+			I2C0_D = transaction->registerAddress;
 			Position++;
 			break;
 		case 2:
-			//restart if CommunicationDirection is READ
-			I2C0_D = WriteByteCopy;
+			I2C0_D = transaction->writeData;
 			Position++;
 			break;
 		default:
-			Stop();
+			Stop(bTRUE);
 		}
 	}
 	else
@@ -365,12 +808,13 @@ void __attribute__ ((interrupt)) I2C_ISR(void)
 		case 0:
 		case 1:
 			//send register address
-			I2C0_D = RegisterAddress;
+			I2C0_D = transaction->registerAddress;
 			Position++;
 			break;
 		case 2:
+			//restart in receive direction
 			I2C0_C1 |= I2C_C1_RSTA_MASK;
-			I2C0_D = I2C_D_READ(SlaveAddress);
+			I2C0_D = I2C_D_READ(transaction->device->slaveAddress);
 			Position++;
 			break;
 		case 3:
@@ -385,26 +829,68 @@ void __attribute__ ((interrupt)) I2C_ISR(void)
 				//1 = NAK
 				I2C0_C1 |= I2C_C1_TXAK_MASK;
 			}
-			*ReadDestination = I2C0_D;		//read out crap
+			(void) I2C0_D;		//read out crap, starts the first byte
+			if (ReceiveMode == I2C_RECEIVE_DMA && RemainingReads() >= I2C_DMA_MIN_BYTES)
+			{
+				StartDMA();
+			}
 			Position++;
 			break;
 		case 4:
-			*ReadDestination++ = I2C0_D;
-			uint8_t remainder = RemainingReads();
-			if (remainder == 0)
+			if (RemainingReads() == 1)
 			{
-				Position++;
+				//Last byte, leave receive mode first so reading it doesn't clock in another
+				EnterCritical();
+				if (QueueCount == 1)
+				{
+					I2C0_C1 &= ~(I2C_C1_MST_MASK | I2C_C1_TXAK_MASK);
+				}
+				else
+				{
+					I2C0_C1 |= I2C_C1_TX_MASK;
+				}
+				*ReadDestination++ = I2C0_D;
+				Finish(bTRUE, bTRUE);
+				ExitCritical();
+				break;
 			}
-			else if (remainder == 1)
+			if (RemainingReads() == 2)
 			{
 				I2C0_C1 |= I2C_C1_TXAK_MASK;
 			}
+			*ReadDestination++ = I2C0_D;
 			break;
 		default:
-			Stop();
+			Stop(bTRUE);
 			break;
 		}
 	}
+	Statistics.interrupts++;
+	Statistics.cycles += BENCH_CYCLES() - start;
+	OS_ISRExit();
+}
+
+void __attribute__ ((interrupt)) I2C_DMA_ISR(void)
+{
+	OS_ISREnter();
+	uint32_t start = BENCH_CYCLES();
+	DMA_CINT = DMA_CINT_CINT(I2C_DMA_CHANNEL);
+	I2C0_C1 &= ~I2C_C1_DMAEN_MASK;
+
+	//Stale, set for every byte the eDMA took
+	I2C0_S |= I2C_S_IICIF_MASK;
+	if (I2C0_S & I2C_S_TCF_MASK)
+	{
+		//The second last arrived before the flag was cleared, so do what the ISR would: NAK the last and start it
+		I2C0_C1 |= I2C_C1_TXAK_MASK;
+		*ReadDestination++ = I2C0_D;
+		I2C0_S |= I2C_S_IICIF_MASK;
+	}
+	//The eDMA read of its last byte started the second last, the ISR sets TXAK once it arrives
+	I2C0_C1 |= I2C_C1_IICIE_MASK;
+
+	Statistics.interrupts++;
+	Statistics.cycles += BENCH_CYCLES() - start;
 	OS_ISRExit();
 }
 /*!
@@ -17,6 +17,100 @@
 // new types
 #include "types.h"
 
+#include "OS.h"
+
+/*!
+ * @brief Number of transactions which can be waiting for the bus.
+ */
+#define I2C_QUEUE_SIZE 8
+
+/*!
+ * @brief Number of queue entries one device may hold at once.
+ */
+#define I2C_DEVICE_QUEUE_LIMIT (I2C_QUEUE_SIZE / 2)
+
+/*!
+ * @brief Number of threads which can be blocked on the I2C at once.
+ */
+#define I2C_BLOCKING_COUNT 4
+
+/*!
+ * @brief Direction of a transaction.
+ */
+typedef enum
+{
+  I2C_READ = 0,
+  I2C_WRITE = 1
+} TI2CCommDirection;
+
+/*!
+ * @brief Reads of at least this many bytes use the eDMA in I2C_RECEIVE_DMA mode.
+ */
+#define I2C_DMA_MIN_BYTES 8
+
+/*!
+ * @brief How the payload of a read is received.
+ */
+typedef enum
+{
+  I2C_RECEIVE_INTERRUPT = 0, /*!< The ISR takes every byte. */
+  I2C_RECEIVE_DMA = 1        /*!< The eDMA takes all but the last 2 bytes. */
+} TI2CReceiveMode;
+
+/*!
+ * @brief Work done in the I2C interrupts.
+ */
+typedef struct
+{
+  uint32_t interrupts;  /*!< Number of I2C and eDMA interrupts. */
+  uint32_t cycles;      /*!< CPU cycles spent in them. */
+} TI2CStatistics;
+
+/*!
+ * @brief Outcome of a transaction.
+ */
+typedef enum
+{
+  I2C_PENDING = 0,
+  I2C_DONE = 1,
+  I2C_FAILED = 2
+} TI2CResult;
+
+/*!
+ * @brief A slave device on the bus.
+ *
+ * Set up with I2C_DeviceInit. Devices with different speeds can share the bus.
+ */
+typedef struct
+{
+  uint8_t slaveAddress;          /*!< The 7-bit slave device address. */
+  uint8_t frequencyDivider;      /*!< The I2C0_F value for the device's baud rate. */
+  uint8_t retries;               /*!< Times a transaction is repeated after a NAK or arbitration loss. */
+  uint8_t queued;                /*!< Number of the device's transactions in the queue. */
+} TI2CDevice;
+
+/*!
+ * @brief An I2C transaction.
+ *
+ * The transaction is copied into the queue, only the buffer and the flag need to outlive the call.
+ */
+typedef struct
+{
+  TI2CDevice *device;            /*!< The device to address. */
+  uint8_t registerAddress;       /*!< The register to read from or write to. */
+  TI2CCommDirection direction;   /*!< Read or write. */
+  uint8_t writeData;             /*!< The byte to write. */
+  uint8_t *readDestination;      /*!< An array with capacity nbBytes to store the bytes that are read. */
+  uint8_t nbBytes;               /*!< The number of bytes to read. */
+  void (*callback)(void*);       /*!< Called from the ISR after the transaction succeeds, may be NULL. */
+  void (*failed)(void*);         /*!< Called from the ISR if the transaction fails after its retries, may be NULL. */
+  void *callbackData;            /*!< Data for the callbacks. */
+  OS_ECB *semaphore;             /*!< Signalled once the transaction has finished, may be NULL. */
+  volatile TI2CResult *result;   /*!< Set once the transaction has finished, may be NULL. */
+  uint8_t retries;               /*!< Retries left, set from the device by I2C_Submit. */
+  BOOL cancelled;                /*!< Set when the owner gives up, the transaction is dropped before it goes on the bus. */
+} TI2CTransaction;
+
 /*! @brief Sets up the I2C before first use.
  *
  *  @param baudRate the target baud rate.
@@ -25,45 +119,112 @@
  */
 BOOL I2C_Init(const uint32_t baudRate, const uint32_t moduleClk);
 
-/*! @brief Selects the current slave device
+/*! @brief Sets up a device handle.
  *
+ * @param device The handle to set up.
  * @param slaveAddress The slave device address.
+ * @param baudRate The baud rate to use with the device.
+ * @param retries Times a transaction is repeated after a NAK or arbitration loss.
+ * @return BOOL - TRUE if the baud rate can be generated.
+ * @note Requires I2C_Init.
+ */
+BOOL I2C_DeviceInit(TI2CDevice * const device, const uint8_t slaveAddress, const uint32_t baudRate, const uint8_t retries);
+
+/*! @brief Queues a transaction.
+ *
+ * Returns immediately. Transactions are run in order, back-to-back from the ISR.
+ * @param transaction The transaction to queue.
+ * @return BOOL - TRUE if the transaction was queued,
+ *   FALSE if the queue is full or the device holds I2C_DEVICE_QUEUE_LIMIT entries.
  */
-void I2C_SelectSlaveDevice(const uint8_t slaveAddress);
+BOOL I2C_Submit(const TI2CTransaction * const transaction);
 
 /*! @brief Write a byte of data to a specified register
  *
+ * @param device The device to address.
  * @param registerAddress The register address.
  * @param data The 8-bit data to write.
  * @param waitCompletion Should wait to return until the operation completes.
+ * @return BOOL - TRUE if the write was queued (and succeeded if waiting).
+ * @note Waiting spins, so this can be used before OS_Start. Threads should use I2C_BlockingWrite.
  */
-void I2C_Write(const uint8_t registerAddress, const uint8_t data, const BOOL waitCompletion);
+BOOL I2C_Write(TI2CDevice * const device, const uint8_t registerAddress, const uint8_t data, const BOOL waitCompletion);
 
 /*! @brief Reads data of a specified length starting from a specified register
  *
  * Uses interrupts as the method of data reception.
+ * @param device The device to address.
  * @param registerAddress The register address.
  * @param destination An array with capacity nbBytes to store the bytes that are read.
  * @param nbBytes The number of bytes to read.
  * @param callback Callback after the operation completes.
- * @param callbackData Data for the callback.
+ * @param failed Callback if the operation fails, may be NULL.
+ * @param callbackData Data for the callbacks.
+ * @return BOOL - TRUE if the read was queued.
  */
-void I2C_IntRead(const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes, void (*callback)(void*), void *callbackData);
+BOOL I2C_IntRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes, void (*callback)(void*), void (*failed)(void*), void *callbackData);
 
 /*! @brief Synchronously reads data of a specified length starting from a specified register
  *
  * Uses interrupts as the method of data reception.
+ * @param device The device to address.
+ * @param registerAddress The register address.
+ * @param destination An array with capacity nbBytes to store the bytes that are read.
+ * @param nbBytes The number of bytes to read.
+ * @return BOOL - TRUE if the read succeeded.
+ * @note Spins, so this can be used before OS_Start. Threads should use I2C_BlockingRead.
+ */
+BOOL I2C_PollRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes);
+
+/*! @brief Write a byte of data to a specified register, sleeping until it completes.
+ *
+ * @param device The device to address.
+ * @param registerAddress The register address.
+ * @param data The 8-bit data to write.
+ * @param timeout The maximum number of OS ticks to wait, 0 waits forever.
+ * @return BOOL - TRUE if the write succeeded.
+ * @note Must only be called from a thread after OS_Start.
+ *   On a timeout the write is cancelled, or aborted if it is on the bus.
+ */
+BOOL I2C_BlockingWrite(TI2CDevice * const device, const uint8_t registerAddress, const uint8_t data, const uint16_t timeout);
+
+/*! @brief Reads data of a specified length starting from a specified register, sleeping until it completes.
+ *
+ * @param device The device to address.
  * @param registerAddress The register address.
  * @param destination An array with capacity nbBytes to store the bytes that are read.
  * @param nbBytes The number of bytes to read.
+ * @param timeout The maximum number of OS ticks to wait, 0 waits forever.
+ * @return BOOL - TRUE if the read succeeded.
+ * @note Must only be called from a thread after OS_Start.
+ *   On a timeout the read is cancelled, or aborted if it is on the bus, destination is no longer written.
+ */
+BOOL I2C_BlockingRead(TI2CDevice * const device, const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes, const uint16_t timeout);
+
+/*! @brief Sets how the payload of long reads is received.
+ *
+ *  @param mode The receive mode, applied from the next read.
  */
-void I2C_PollRead(const uint8_t registerAddress, uint8_t* const destination, const uint8_t nbBytes);
+void I2C_SetReceiveMode(const TI2CReceiveMode mode);
+
+/*! @brief Reads and clears the interrupt statistics.
+ *
+ *  @param statistics is filled with the counts since the last call.
+ */
+void I2C_GetStatistics(TI2CStatistics * const statistics);
 
 /*!
  * @brief Interrupt service for the I2C module.
  */
 void __attribute__ ((interrupt)) I2C_ISR(void);
 
+/*!
+ * @brief Interrupt service for the eDMA channel which receives the I2C payload.
+ *
+ * Hands the last 2 bytes of the read back to I2C_ISR.
+ */
+void __attribute__ ((interrupt)) I2C_DMA_ISR(void);
+
 #endif
 /*!
 ** @}
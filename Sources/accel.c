@@ -20,6 +20,9 @@
 // Median filter
 #include "median.h"
 
+// Cycle counter
+#include "bench.h"
+
 #include "OS.h"
 
 // K70 module registers
@@ -29,18 +32,6 @@
 #include "CPU.h"
 #include "PE_types.h"
 
-typedef enum
-{
-  DATE_RATE_800_HZ,
-  DATE_RATE_400_HZ,
-  DATE_RATE_200_HZ,
-  DATE_RATE_100_HZ,
-  DATE_RATE_50_HZ,
-  DATE_RATE_12_5_HZ,
-  DATE_RATE_6_25_HZ,
-  DATE_RATE_1_56_HZ
-} TOutputDataRate;
-
 typedef enum
 {
   SLEEP_MODE_RATE_50_HZ,
@@ -60,8 +51,31 @@ typedef enum
 #define MMA8451Q_OUT_Y_LSB  0x04u
 #define MMA8451Q_OUT_Z_MSB  0x05u
 #define MMA8451Q_OUT_Z_LSB  0x06u
+#define MMA8451Q_F_SETUP    0x09u
+#define MMA8451Q_SYSMOD     0x0Bu
 #define MMA8451Q_INT_SOURCE 0x0Cu
 #define MMA8451Q_WHO_AM_I   0x0Du
+#define MMA8451Q_XYZ_DATA_CFG 0x0Eu
+#define MMA8451Q_PL_STATUS  0x10u
+#define MMA8451Q_PL_CFG     0x11u
+#define MMA8451Q_PL_COUNT   0x12u
+#define MMA8451Q_FF_MT_CFG  0x15u
+#define MMA8451Q_FF_MT_SRC  0x16u
+#define MMA8451Q_FF_MT_THS  0x17u
+#define MMA8451Q_FF_MT_COUNT 0x18u
+#define MMA8451Q_TRANSIENT_CFG   0x1Du
+#define MMA8451Q_TRANSIENT_SRC   0x1Eu
+#define MMA8451Q_TRANSIENT_THS   0x1Fu
+#define MMA8451Q_TRANSIENT_COUNT 0x20u
+#define MMA8451Q_PULSE_CFG  0x21u
+#define MMA8451Q_PULSE_SRC  0x22u
+#define MMA8451Q_PULSE_THSX 0x23u
+#define MMA8451Q_PULSE_THSY 0x24u
+#define MMA8451Q_PULSE_THSZ 0x25u
+#define MMA8451Q_PULSE_TMLT 0x26u
+#define MMA8451Q_PULSE_LTCY 0x27u
+#define MMA8451Q_PULSE_WIND 0x28u
+#define MMA8451Q_ASLP_COUNT 0x29u
 #define MMA8451Q_CTRL_REG1  0x2Au
 #define MMA8451Q_CTRL_REG2  0x2Bu
 #define MMA8451Q_CTRL_REG3  0x2Cu
@@ -77,6 +91,17 @@ typedef enum
 #define MMA8451Q_STATUS_ZOW_MASK   0x40u
 #define MMA8451Q_STATUS_ZYXOW_MASK 0x80u
 
+//STATUS reads as F_STATUS when the FIFO is on
+#define MMA8451Q_F_STATUS_F_CNT_MASK 0x3Fu
+#define MMA8451Q_F_STATUS_F_WMRK_FLAG_MASK 0x40u
+#define MMA8451Q_F_STATUS_F_OVF_MASK 0x80u
+
+#define MMA8451Q_F_SETUP_F_WMRK(x)  ((x) & 0x3Fu)
+#define MMA8451Q_F_SETUP_F_MODE_CIRCULAR 0x40u
+
+#define MMA8451Q_SYSMOD_MASK  0x3u
+#define MMA8451Q_SYSMOD_SLEEP 0x2u
+
 #define MMA8451Q_INT_SOURCE_SRC_DRDY_MASK   0x1u
 #define MMA8451Q_INT_SOURCE_SRC_FF_MT_MASK  0x4u
 #define MMA8451Q_INT_SOURCE_SRC_PULSE_MASK  0x8u
@@ -91,8 +116,31 @@ typedef enum
 #define MMA8451Q_CTRL_REG1_F_READ_MASK  	0x2u
 #define MMA8451Q_CTRL_REG1_LNOISE_MASK  	0x4u
 #define MMA8451Q_CTRL_REG1_DR_MASK	    	0x38u
+#define MMA8451Q_CTRL_REG1_DR(x)	    	(((x) << 3) & MMA8451Q_CTRL_REG1_DR_MASK)
 #define MMA8451Q_CTRL_REG1_ASLP_RATE_MASK	0xC0u
+#define MMA8451Q_CTRL_REG1_ASLP_RATE(x)	(((x) << 6) & MMA8451Q_CTRL_REG1_ASLP_RATE_MASK)
 
+#define MMA8451Q_PL_CFG_DBCNTM_MASK 0x80u
+#define MMA8451Q_PL_CFG_PL_EN_MASK  0x40u
+
+#define MMA8451Q_FF_MT_CFG_ELE_MASK  0x80u
+#define MMA8451Q_FF_MT_CFG_OAE_MASK  0x40u
+#define MMA8451Q_FF_MT_CFG_XYZ_MASK  0x38u
+
+#define MMA8451Q_TRANSIENT_CFG_ELE_MASK 0x10u
+#define MMA8451Q_TRANSIENT_CFG_XYZ_MASK 0x0Eu
+
+#define MMA8451Q_PULSE_CFG_ELE_MASK    0x40u
+#define MMA8451Q_PULSE_CFG_SINGLE_MASK 0x15u
+
+#define MMA8451Q_XYZ_DATA_CFG_FS_MASK 0x3u
+#define MMA8451Q_XYZ_DATA_CFG_FS(x)   ((x) & MMA8451Q_XYZ_DATA_CFG_FS_MASK)
+
+#define MMA8451Q_CTRL_REG2_MODS_MASK 0x3u
+#define MMA8451Q_CTRL_REG2_MODS(x)   ((x) & MMA8451Q_CTRL_REG2_MODS_MASK)
+#define MMA8451Q_CTRL_REG2_SLPE_MASK  0x4u
+#define MMA8451Q_CTRL_REG2_SMODS_MASK 0x18u
+#define MMA8451Q_CTRL_REG2_SMODS(x)   (((x) << 3) & MMA8451Q_CTRL_REG2_SMODS_MASK)
 #define MMA8451Q_CTRL_REG2_RST_MASK 0x40u
 
 #define MMA8451Q_CTRL_REG3_PP_OD_MASK		    0x1u
@@ -119,6 +167,99 @@ typedef enum
 #define MMA8451Q_CTRL_REG5_INT_CFG_FIFO_MASK   0x40u
 #define MMA8451Q_CTRL_REG5_INT_CFG_ASLP_MASK   0x80u
 
+/*!
+ * @brief OS ticks to wait for a configuration transfer before giving up.
+ */
+#define ACCEL_I2C_TIMEOUT 10
+
+/*!
+ * @brief I2C baud rate used with the accelerometer.
+ */
+#define ACCEL_I2C_BAUD_RATE 100000
+
+/*!
+ * @brief Times an I2C transaction with the accelerometer is retried.
+ */
+#define ACCEL_I2C_RETRIES 2
+
+/*!
+ * @brief Output data rate after initialization.
+ */
+#define ACCEL_DEFAULT_DATA_RATE ACCEL_DATA_RATE_1_56_HZ
+
+/*!
+ * @brief Full-scale range after initialization.
+ */
+#define ACCEL_DEFAULT_RANGE ACCEL_RANGE_2G
+
+/*!
+ * @brief Oversampling mode after initialization.
+ */
+#define ACCEL_DEFAULT_OVERSAMPLING ACCEL_OVERSAMPLING_NORMAL
+
+/*!
+ * @brief Event thresholds, 0.063 g per count in every range.
+ */
+#define ACCEL_FREEFALL_THRESHOLD  0x03 /* 0.19 g */
+#define ACCEL_MOTION_THRESHOLD    0x18 /* 1.5 g */
+#define ACCEL_TRANSIENT_THRESHOLD 0x08 /* 0.5 g */
+#define ACCEL_TAP_THRESHOLD_XY    0x19 /* 1.6 g */
+#define ACCEL_TAP_THRESHOLD_Z     0x2A /* 2.6 g, on top of gravity */
+
+/*!
+ * @brief Samples a freefall, motion or transient condition must last.
+ */
+#define ACCEL_EVENT_DEBOUNCE 2
+
+/*!
+ * @brief Tap time limit and latency, in the units of the data rate (0.625 ms and 1.25 ms at 400 Hz).
+ */
+#define ACCEL_TAP_TIME_LIMIT 0x30
+#define ACCEL_TAP_LATENCY    0x50
+
+/*!
+ * @brief Samples an orientation must be held for.
+ */
+#define ACCEL_ORIENTATION_DEBOUNCE 5
+
+/*!
+ * @brief Output data rate while asleep.
+ */
+#define ACCEL_SLEEP_RATE SLEEP_MODE_RATE_1_56_HZ
+
+/*!
+ * @brief Idle time before the accelerometer sleeps, in ASLP_COUNT steps (320 ms, 640 ms at 1.56 Hz).
+ */
+#define ACCEL_SLEEP_TIMEOUT 16
+
+/*!
+ * @brief Engines used in ACCEL_EVENT mode after initialization.
+ */
+#define ACCEL_DEFAULT_EVENTS (ACCEL_EVENT_FREEFALL | ACCEL_EVENT_TRANSIENT | ACCEL_EVENT_TAP | ACCEL_EVENT_ORIENTATION)
+
+/*!
+ * @brief Source register of each engine, by its INT_SOURCE bit.
+ */
+const static struct
+{
+  uint8_t sourceMask;
+  uint8_t reg;
+} EngineSources[ACCEL_EVENT_MAX] = {
+		{ MMA8451Q_INT_SOURCE_SRC_FF_MT_MASK, MMA8451Q_FF_MT_SRC },
+		{ MMA8451Q_INT_SOURCE_SRC_TRANS_MASK, MMA8451Q_TRANSIENT_SRC },
+		{ MMA8451Q_INT_SOURCE_SRC_PULSE_MASK, MMA8451Q_PULSE_SRC },
+		{ MMA8451Q_INT_SOURCE_SRC_LNDPRT_MASK, MMA8451Q_PL_STATUS } };
+
+/*!
+ * @brief Microseconds between samples at each TAccelDataRate.
+ */
+const static uint32_t SamplePeriods[] = { 1250, 2500, 5000, 10000, 20000, 80000, 160000, 640000 };
+
+/*!
+ * @brief Microseconds between samples at each TSLEEPModeRate.
+ */
+const static uint32_t SleepPeriods[] = { 20000, 80000, 160000, 640000 };
+
 /*!
  * @brief Callback once data is available.
  */
@@ -139,11 +280,141 @@ static void (*ReadCallback)(void *);
  */
 static void *ReadCallbackArgument;
 
+/*!
+ * @brief The accelerometer on the I2C bus.
+ */
+static TI2CDevice Device;
+
 /*!
  * @brief The current mode of the accel module.
  */
 static TAccelMode CurrentMode;
 
+/*!
+ * @brief The current output data rate.
+ */
+static TAccelDataRate CurrentDataRate;
+
+/*!
+ * @brief The current full-scale range.
+ */
+static TAccelRange CurrentRange;
+
+/*!
+ * @brief The current oversampling mode.
+ */
+static TAccelOversampling CurrentOversampling;
+
+/*!
+ * @brief The current resolution of the samples.
+ */
+static TAccelResolution CurrentResolution = ACCEL_RESOLUTION_8_BIT;
+
+/*!
+ * @brief Registers read for each sample, at most 6 in ACCEL_RESOLUTION_14_BIT.
+ */
+static uint8_t SampleSize = 3;
+
+/*!
+ * @brief SampleSize when the read in progress was queued.
+ */
+static uint8_t ReadSampleSize;
+
+/*!
+ * @brief The data registers as read, up to a full FIFO.
+ */
+static uint8_t RawData[ACCEL_FIFO_SIZE * 6];
+
+/*!
+ * @brief Destination of the XYZ read in progress.
+ */
+static TAccelSample *XYZDestination;
+
+/*!
+ * @brief Destination of the FIFO read in progress.
+ */
+static TAccelFIFO *FIFODestination;
+
+/*!
+ * @brief F_STATUS read at the start of a FIFO read.
+ */
+static uint8_t FIFOStatus;
+
+/*!
+ * @brief The engines used in ACCEL_EVENT mode.
+ */
+static uint8_t EventEngines = ACCEL_DEFAULT_EVENTS;
+
+/*!
+ * @brief OS_TimeGet when the last event interrupt was taken.
+ */
+static uint32_t EventTime;
+
+/*!
+ * @brief INT_SOURCE read at the start of an event read.
+ */
+static uint8_t EventSource;
+
+/*!
+ * @brief Source register reads of the event read in progress still to complete.
+ */
+static uint8_t EventReadsPending;
+
+/*!
+ * @brief Bit of each event whose source register couldn't be read.
+ */
+static uint8_t EventReadsFailed;
+
+/*!
+ * @brief Destination of the event read in progress.
+ */
+static TAccelEvents *EventsDestination;
+
+/*!
+ * @brief How reads follow the data ready callback.
+ */
+static TAccelAcquisition Acquisition = ACCEL_ACQUISITION_THREAD;
+
+/*!
+ * @brief Asserted if the accelerometer sleeps when idle.
+ */
+static BOOL AutoSleep = bFALSE;
+
+/*!
+ * @brief The power state as of the last SYSMOD read.
+ */
+static TAccelPowerState PowerState = ACCEL_POWER_WAKE;
+
+/*!
+ * @brief SYSMOD and INT_SOURCE, read ahead of each read while AutoSleep is on.
+ */
+static uint8_t SleepStatus[2];
+
+/*!
+ * @brief Interrupts, time and latency, for Accel_GetSleepStatistics.
+ */
+static TAccelSleepStatistics SleepStatistics;
+
+/*!
+ * @brief OS_TimeGet when PowerState last changed.
+ */
+static uint32_t PowerStateSince;
+
+/*!
+ * @brief Cycle counter at the last interrupt.
+ */
+static uint32_t InterruptCycles;
+
+/*!
+ * @brief Cycle counter at the interrupt which reported the last sleep or wake.
+ */
+static uint32_t SwitchCycles;
+
+/*!
+ * @brief Asserted between a sleep or wake and the next interrupt.
+ */
+static BOOL LatencyPending = bFALSE;
+
 /*!
  * @brief Change the active mode of the accelerometer.
  *
@@ -152,7 +423,10 @@ static TAccelMode CurrentMode;
 void SetActive(BOOL isActive)
 {
 	uint8_t reg1Tmp;
-	I2C_PollRead(MMA8451Q_CTRL_REG1, &reg1Tmp, 1);
+	if (!I2C_BlockingRead(&Device, MMA8451Q_CTRL_REG1, &reg1Tmp, 1, ACCEL_I2C_TIMEOUT))
+	{
+		return;
+	}
 	if (isActive)
 	{
 		reg1Tmp |= MMA8451Q_CTRL_REG1_ACTIVE_MASK;
@@ -161,7 +435,48 @@ void SetActive(BOOL isActive)
 	{
 		reg1Tmp &= ~MMA8451Q_CTRL_REG1_ACTIVE_MASK;
 	}
-	I2C_Write(MMA8451Q_CTRL_REG1, reg1Tmp, bFALSE);
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_CTRL_REG1, reg1Tmp, ACCEL_I2C_TIMEOUT);
+}
+
+/*!
+ * @brief Replace some bits of a register.
+ *
+ * @param reg The register.
+ * @param mask The bits to replace.
+ * @param value The new bits, already in position.
+ * @return bTRUE if the register was written.
+ */
+static BOOL UpdateRegister(const uint8_t reg, const uint8_t mask, const uint8_t value)
+{
+	uint8_t regTmp;
+	if (!I2C_BlockingRead(&Device, reg, &regTmp, 1, ACCEL_I2C_TIMEOUT))
+	{
+		return bFALSE;
+	}
+	regTmp = (regTmp & ~mask) | (value & mask);
+	return I2C_BlockingWrite(&Device, reg, regTmp, ACCEL_I2C_TIMEOUT);
+}
+
+/*!
+ * @brief Convert the data registers of one sample.
+ *
+ * @param raw The MSB (and LSB) registers of X, Y and Z, in register order, ReadSampleSize bytes.
+ * @param sample Where the 14-bit counts are stored.
+ */
+static void Decode(const uint8_t * const raw, TAccelSample * const sample)
+{
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		if (ReadSampleSize == 6)
+		{
+			//Left justified, the arithmetic shift keeps the sign
+			sample->axes[axis] = (int16_t) (((uint16_t) raw[axis * 2] << 8) | raw[axis * 2 + 1]) >> 2;
+		}
+		else
+		{
+			sample->axes[axis] = (int16_t) (int8_t) raw[axis] * 64;
+		}
+	}
 }
 
 BOOL Accel_Init(const TAccelSetup* const accelSetup)
@@ -187,10 +502,13 @@ BOOL Accel_Init(const TAccelSetup* const accelSetup)
 
 	//Check if we are connected to the correct device
 	uint8_t whoAmI;
-	I2C_SelectSlaveDevice(MMA8451Q_ADDR_SA0_HIGH);
+	if (!I2C_DeviceInit(&Device, MMA8451Q_ADDR_SA0_HIGH, ACCEL_I2C_BAUD_RATE, ACCEL_I2C_RETRIES))
+	{
+		return bFALSE;
+	}
 	//TODO: uncomment
 	/*
-	I2C_PollRead(MMA8451Q_WHO_AM_I, &whoAmI, 1);
+	I2C_PollRead(&Device, MMA8451Q_WHO_AM_I, &whoAmI, 1);
 
 	if (whoAmI != MMA8451Q_WHO_AM_I_VALUE)
 	{
@@ -201,13 +519,24 @@ BOOL Accel_Init(const TAccelSetup* const accelSetup)
 
 	//Reset the accelerometer
 	//TODO: uncomment
-	/*I2C_Write(MMA8451Q_CTRL_REG2, MMA8451Q_CTRL_REG2_RST_MASK, bFALSE);
+	/*I2C_Write(&Device, MMA8451Q_CTRL_REG2, MMA8451Q_CTRL_REG2_RST_MASK, bFALSE);
 	uint8_t reg2 = MMA8451Q_CTRL_REG2_RST_MASK;
 	while (reg2 & MMA8451Q_CTRL_REG2_RST_MASK)
 	{
-		I2C_PollRead(MMA8451Q_CTRL_REG2, &reg2, 1);
+		I2C_PollRead(&Device, MMA8451Q_CTRL_REG2, &reg2, 1);
 	}*/
 
+	//The range and oversampling can only be written in standby
+	CurrentDataRate = ACCEL_DEFAULT_DATA_RATE;
+	CurrentRange = ACCEL_DEFAULT_RANGE;
+	CurrentOversampling = ACCEL_DEFAULT_OVERSAMPLING;
+	if (!I2C_BlockingWrite(&Device, MMA8451Q_CTRL_REG1, 0, ACCEL_I2C_TIMEOUT)
+			|| !I2C_BlockingWrite(&Device, MMA8451Q_XYZ_DATA_CFG, MMA8451Q_XYZ_DATA_CFG_FS(CurrentRange), ACCEL_I2C_TIMEOUT)
+			|| !I2C_BlockingWrite(&Device, MMA8451Q_CTRL_REG2, MMA8451Q_CTRL_REG2_MODS(CurrentOversampling), ACCEL_I2C_TIMEOUT))
+	{
+		return bFALSE;
+	}
+
 	/*
 	 * activate
 	 * enable fast read
@@ -215,14 +544,327 @@ BOOL Accel_Init(const TAccelSetup* const accelSetup)
 	 * data rate 1.56Hz (0x38)
 	 *
 	 */
-	I2C_Write(MMA8451Q_CTRL_REG1, (0x38 | MMA8451Q_CTRL_REG1_ACTIVE_MASK | MMA8451Q_CTRL_REG1_F_READ_MASK | MMA8451Q_CTRL_REG1_LNOISE_MASK), bFALSE);
-	return bTRUE;
+	return I2C_BlockingWrite(&Device, MMA8451Q_CTRL_REG1, (MMA8451Q_CTRL_REG1_DR(CurrentDataRate) | MMA8451Q_CTRL_REG1_ACTIVE_MASK | MMA8451Q_CTRL_REG1_F_READ_MASK | MMA8451Q_CTRL_REG1_LNOISE_MASK), ACCEL_I2C_TIMEOUT);
+}
+
+/*!
+ * @brief Called from the I2C ISR with SYSMOD, follows the sleep and wake switches.
+ *
+ * @param arguments Unused.
+ */
+static void SleepStatusComplete(void *arguments)
+{
+	TAccelPowerState state = ((SleepStatus[0] & MMA8451Q_SYSMOD_MASK) == MMA8451Q_SYSMOD_SLEEP) ? ACCEL_POWER_SLEEP : ACCEL_POWER_WAKE;
+	if (state == PowerState)
+	{
+		return;
+	}
+	uint32_t now = OS_TimeGet();
+	SleepStatistics.ticks[PowerState] += now - PowerStateSince;
+	PowerStateSince = now;
+	PowerState = state;
+	//The next interrupt is the first sample at the new rate
+	SwitchCycles = InterruptCycles;
+	LatencyPending = bTRUE;
+}
+
+/*!
+ * @brief Queue a read of SYSMOD, which also clears the sleep/wake interrupt.
+ *
+ * Does nothing unless auto-sleep is on.
+ */
+static void ReadSleepStatus()
+{
+	if (AutoSleep)
+	{
+		(void) I2C_IntRead(&Device, MMA8451Q_SYSMOD, SleepStatus, sizeof(SleepStatus), SleepStatusComplete, (void *) 0, (void *) 0);
+	}
+}
+
+/*!
+ * @brief Called from the I2C ISR with the XYZ registers.
+ *
+ * @param arguments Unused.
+ */
+static void XYZComplete(void *arguments)
+{
+	Decode(RawData, XYZDestination);
+	(*ReadCallback)(ReadCallbackArgument);
+}
+
+void Accel_ReadXYZ(TAccelSample * const sample)
+{
+	ReadSleepStatus();
+	XYZDestination = sample;
+	ReadSampleSize = SampleSize;
+	(void) I2C_IntRead(&Device, MMA8451Q_OUT_X_MSB, RawData, SampleSize, XYZComplete, (void *) 0, (void *) 0);
+}
+
+/*!
+ * @brief Called from the I2C ISR with the FIFO samples.
+ *
+ * @param arguments Unused.
+ */
+static void FIFOBurstComplete(void *arguments)
+{
+	for (uint8_t i = 0; i < FIFODestination->count; i++)
+	{
+		Decode(&RawData[i * ReadSampleSize], &FIFODestination->samples[i]);
+	}
+	(*ReadCallback)(ReadCallbackArgument);
+}
+
+/*!
+ * @brief Called from the I2C ISR when the FIFO status or samples couldn't be read.
+ *
+ * Nothing is read, the samples stay in the FIFO for the next read.
+ * @param arguments Unused.
+ */
+static void FIFOReadFailed(void *arguments)
+{
+	FIFODestination->count = 0;
+	(*ReadCallback)(ReadCallbackArgument);
+}
+
+/*!
+ * @brief Called from the I2C ISR with the FIFO status, starts the burst of the buffered samples.
+ *
+ * @param arguments Unused.
+ */
+static void FIFOStatusComplete(void *arguments)
+{
+	uint8_t count = FIFOStatus & MMA8451Q_F_STATUS_F_CNT_MASK;
+	if (count > ACCEL_FIFO_SIZE)
+	{
+		count = ACCEL_FIFO_SIZE;
+	}
+	FIFODestination->count = count;
+	if (count == 0)
+	{
+		(*ReadCallback)(ReadCallbackArgument);
+		return;
+	}
+	//The address wraps back to OUT_X_MSB (after OUT_Z_MSB or OUT_Z_LSB), so the whole FIFO comes out in one read
+	ReadSampleSize = SampleSize;
+	if (!I2C_IntRead(&Device, MMA8451Q_OUT_X_MSB, RawData, count * ReadSampleSize, FIFOBurstComplete, FIFOReadFailed, (void *) 0))
+	{
+		FIFOReadFailed((void *) 0);
+	}
+}
+
+BOOL Accel_ReadFIFO(TAccelFIFO * const fifo)
+{
+	ReadSleepStatus();
+	FIFODestination = fifo;
+	return I2C_IntRead(&Device, MMA8451Q_STATUS, &FIFOStatus, 1, FIFOStatusComplete, FIFOReadFailed, (void *) 0);
+}
+
+/*!
+ * @brief Count off a source register read, the read complete callback is called after the last.
+ *
+ * Events whose source register couldn't be read are dropped,
+ * their engine still holds the interrupt line so the next read picks them up.
+ */
+static void EventReadDone()
+{
+	if (--EventReadsPending)
+	{
+		return;
+	}
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < EventsDestination->count; i++)
+	{
+		if (!(EventReadsFailed & (1 << i)))
+		{
+			EventsDestination->events[count++] = EventsDestination->events[i];
+		}
+	}
+	EventsDestination->count = count;
+	(*ReadCallback)(ReadCallbackArgument);
+}
+
+/*!
+ * @brief Called from the I2C ISR with each engine source register.
+ *
+ * @param arguments Unused.
+ */
+static void EventSourceComplete(void *arguments)
+{
+	EventReadDone();
+}
+
+/*!
+ * @brief Called from the I2C ISR when an engine source register couldn't be read.
+ *
+ * @param arguments The index of the event.
+ */
+static void EventSourceFailed(void *arguments)
+{
+	EventReadsFailed |= 1 << (uint32_t) arguments;
+	EventReadDone();
+}
+
+/*!
+ * @brief Called from the I2C ISR with INT_SOURCE, reads the source register of each engine which fired.
+ *
+ * @param arguments Unused.
+ */
+static void EventStatusComplete(void *arguments)
+{
+	uint8_t count = 0;
+	EventsDestination->time = EventTime;
+	//Held until every read is queued, so the callback comes once whichever way they finish
+	EventReadsPending = 1;
+	for (uint8_t i = 0; i < ACCEL_EVENT_MAX; i++)
+	{
+		if (!(EventSource & EngineSources[i].sourceMask))
+		{
+			continue;
+		}
+		switch (EngineSources[i].sourceMask)
+		{
+		case MMA8451Q_INT_SOURCE_SRC_FF_MT_MASK:
+			EventsDestination->events[count].engine = (EventEngines & ACCEL_EVENT_MOTION) ? ACCEL_EVENT_MOTION : ACCEL_EVENT_FREEFALL;
+			break;
+		case MMA8451Q_INT_SOURCE_SRC_TRANS_MASK:
+			EventsDestination->events[count].engine = ACCEL_EVENT_TRANSIENT;
+			break;
+		case MMA8451Q_INT_SOURCE_SRC_PULSE_MASK:
+			EventsDestination->events[count].engine = ACCEL_EVENT_TAP;
+			break;
+		default:
+			EventsDestination->events[count].engine = ACCEL_EVENT_ORIENTATION;
+			break;
+		}
+		//Reading the source register clears the engine's interrupt, one left unread keeps the line low for the next read
+		if (I2C_IntRead(&Device, EngineSources[i].reg, &EventsDestination->events[count].source, 1,
+				EventSourceComplete, EventSourceFailed, (void *) (uint32_t) count))
+		{
+			EventReadsPending++;
+			count++;
+		}
+	}
+	EventsDestination->count = count;
+	EventReadDone();
 }
 
-void Accel_ReadXYZ(uint8_t data[3])
+/*!
+ * @brief Called from the I2C ISR when INT_SOURCE couldn't be read.
+ *
+ * @param arguments Unused.
+ */
+static void EventStatusFailed(void *arguments)
 {
-	I2C_SelectSlaveDevice(MMA8451Q_ADDR_SA0_HIGH);
-	I2C_IntRead(MMA8451Q_OUT_X_MSB, data, 3, ReadCallback, ReadCallbackArgument);
+	EventsDestination->count = 0;
+	(*ReadCallback)(ReadCallbackArgument);
+}
+
+BOOL Accel_ReadEvents(TAccelEvents * const events)
+{
+	ReadSleepStatus();
+	EventsDestination = events;
+	EventReadsFailed = 0;
+	return I2C_IntRead(&Device, MMA8451Q_INT_SOURCE, &EventSource, 1, EventStatusComplete, EventStatusFailed, (void *) 0);
+}
+
+BOOL Accel_InterruptAsserted()
+{
+	//INT2 is active low on PTB7
+	return (GPIOB_PDIR & (1 << 7)) ? bFALSE : bTRUE;
+}
+
+/*!
+ * @brief Configure the event engines, the accelerometer must be in standby.
+ *
+ * @param engines The ACCEL_EVENT_* engines to enable, the others are turned off.
+ * @return The CTRL_REG4 interrupt enables of the engines.
+ */
+static uint8_t ConfigureEngines(const uint8_t engines)
+{
+	uint8_t reg4 = 0;
+
+	//Freefall and motion share an engine, freefall is all axes below the threshold
+	uint8_t ffmtCfg = 0;
+	if (engines & (ACCEL_EVENT_FREEFALL | ACCEL_EVENT_MOTION))
+	{
+		BOOL motion = (engines & ACCEL_EVENT_MOTION) ? bTRUE : bFALSE;
+		ffmtCfg = MMA8451Q_FF_MT_CFG_ELE_MASK | MMA8451Q_FF_MT_CFG_XYZ_MASK | (motion ? MMA8451Q_FF_MT_CFG_OAE_MASK : 0);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_FF_MT_THS, motion ? ACCEL_MOTION_THRESHOLD : ACCEL_FREEFALL_THRESHOLD, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_FF_MT_COUNT, ACCEL_EVENT_DEBOUNCE, ACCEL_I2C_TIMEOUT);
+		reg4 |= MMA8451Q_CTRL_REG4_INT_EN_FF_MT_MASK;
+	}
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_FF_MT_CFG, ffmtCfg, ACCEL_I2C_TIMEOUT);
+
+	//High-pass filtered, so only changes count
+	uint8_t transientCfg = 0;
+	if (engines & ACCEL_EVENT_TRANSIENT)
+	{
+		transientCfg = MMA8451Q_TRANSIENT_CFG_ELE_MASK | MMA8451Q_TRANSIENT_CFG_XYZ_MASK;
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_THS, ACCEL_TRANSIENT_THRESHOLD, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_COUNT, ACCEL_EVENT_DEBOUNCE, ACCEL_I2C_TIMEOUT);
+		reg4 |= MMA8451Q_CTRL_REG4_INT_EN_TRANS_MASK;
+	}
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_CFG, transientCfg, ACCEL_I2C_TIMEOUT);
+
+	//Single taps on each axis
+	uint8_t pulseCfg = 0;
+	if (engines & ACCEL_EVENT_TAP)
+	{
+		pulseCfg = MMA8451Q_PULSE_CFG_ELE_MASK | MMA8451Q_PULSE_CFG_SINGLE_MASK;
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_THSX, ACCEL_TAP_THRESHOLD_XY, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_THSY, ACCEL_TAP_THRESHOLD_XY, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_THSZ, ACCEL_TAP_THRESHOLD_Z, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_TMLT, ACCEL_TAP_TIME_LIMIT, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_LTCY, ACCEL_TAP_LATENCY, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_WIND, 0, ACCEL_I2C_TIMEOUT);
+		reg4 |= MMA8451Q_CTRL_REG4_INT_EN_PULSE_MASK;
+	}
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_PULSE_CFG, pulseCfg, ACCEL_I2C_TIMEOUT);
+
+	uint8_t plCfg = 0;
+	if (engines & ACCEL_EVENT_ORIENTATION)
+	{
+		plCfg = MMA8451Q_PL_CFG_DBCNTM_MASK | MMA8451Q_PL_CFG_PL_EN_MASK;
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_PL_COUNT, ACCEL_ORIENTATION_DEBOUNCE, ACCEL_I2C_TIMEOUT);
+		reg4 |= MMA8451Q_CTRL_REG4_INT_EN_LNDPRT_MASK;
+	}
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_PL_CFG, plCfg, ACCEL_I2C_TIMEOUT);
+
+	return reg4;
+}
+
+/*!
+ * @brief Set up the wake sources for auto-sleep, the accelerometer must be in standby.
+ *
+ * @param engines The CTRL_REG4 interrupt enables of the running engines.
+ * @return The CTRL_REG3 wake bits.
+ */
+static uint8_t ConfigureWake(const uint8_t engines)
+{
+	uint8_t reg3 = 0;
+	if (engines & MMA8451Q_CTRL_REG4_INT_EN_FF_MT_MASK)
+	{
+		reg3 |= MMA8451Q_CTRL_REG3_WAKE_FF_MT_MASK;
+	}
+	if (engines & MMA8451Q_CTRL_REG4_INT_EN_PULSE_MASK)
+	{
+		reg3 |= MMA8451Q_CTRL_REG3_WAKE_PULSE_MASK;
+	}
+	if (engines & MMA8451Q_CTRL_REG4_INT_EN_LNDPRT_MASK)
+	{
+		reg3 |= MMA8451Q_CTRL_REG3_WAKE_LNDPRT_MASK;
+	}
+	if (!(engines & MMA8451Q_CTRL_REG4_INT_EN_TRANS_MASK))
+	{
+		//Not latched and no interrupt of its own, it only wakes
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_THS, ACCEL_TRANSIENT_THRESHOLD, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_COUNT, ACCEL_EVENT_DEBOUNCE, ACCEL_I2C_TIMEOUT);
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_TRANSIENT_CFG, MMA8451Q_TRANSIENT_CFG_XYZ_MASK, ACCEL_I2C_TIMEOUT);
+	}
+	reg3 |= MMA8451Q_CTRL_REG3_WAKE_TRANS_MASK;
+
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_ASLP_COUNT, ACCEL_SLEEP_TIMEOUT, ACCEL_I2C_TIMEOUT);
+	return reg3;
 }
 
 void Accel_SetMode(const TAccelMode mode)
@@ -232,21 +874,59 @@ void Accel_SetMode(const TAccelMode mode)
 
 	//Read register 4 of the accelerometer
 	uint8_t reg4Tmp;
-	I2C_PollRead(MMA8451Q_CTRL_REG4, &reg4Tmp, 1);
+	if (!I2C_BlockingRead(&Device, MMA8451Q_CTRL_REG4, &reg4Tmp, 1, ACCEL_I2C_TIMEOUT))
+	{
+		return;
+	}
+	reg4Tmp &= ~(MMA8451Q_CTRL_REG4_INT_EN_DRDY_MASK | MMA8451Q_CTRL_REG4_INT_EN_FIFO_MASK
+			| MMA8451Q_CTRL_REG4_INT_EN_FF_MT_MASK | MMA8451Q_CTRL_REG4_INT_EN_PULSE_MASK
+			| MMA8451Q_CTRL_REG4_INT_EN_LNDPRT_MASK | MMA8451Q_CTRL_REG4_INT_EN_TRANS_MASK);
+	uint8_t fSetup = 0;
 	switch (mode)
 	{
-	case ACCEL_POLL:
-		reg4Tmp &= ~MMA8451Q_CTRL_REG4_INT_EN_DRDY_MASK;
 	case ACCEL_INT:
-	default:
 		reg4Tmp |= MMA8451Q_CTRL_REG4_INT_EN_DRDY_MASK;
+		break;
+	case ACCEL_FIFO:
+		//Interrupt once the watermark is reached, the oldest samples are dropped on overflow
+		reg4Tmp |= MMA8451Q_CTRL_REG4_INT_EN_FIFO_MASK;
+		fSetup = MMA8451Q_F_SETUP_F_MODE_CIRCULAR | MMA8451Q_F_SETUP_F_WMRK(ACCEL_FIFO_WATERMARK);
+		break;
+	case ACCEL_POLL:
+	default:
+		break;
 	}
 
 	/*Active off*/
 	SetActive(bFALSE);
 
+	/*The engines are only running in event mode*/
+	uint8_t engines = ConfigureEngines((mode == ACCEL_EVENT) ? EventEngines : 0);
+	reg4Tmp |= engines;
+
+	/*Any running engine wakes it, outside event mode the transient engine is run for this alone*/
+	reg4Tmp &= ~MMA8451Q_CTRL_REG4_INT_EN_ASLP_MASK;
+	uint8_t reg3 = 0;
+	if (AutoSleep)
+	{
+		reg3 = ConfigureWake(engines);
+		reg4Tmp |= MMA8451Q_CTRL_REG4_INT_EN_ASLP_MASK;
+	}
+	(void) UpdateRegister(MMA8451Q_CTRL_REG3, MMA8451Q_CTRL_REG3_WAKE_FF_MT_MASK | MMA8451Q_CTRL_REG3_WAKE_PULSE_MASK
+			| MMA8451Q_CTRL_REG3_WAKE_LNDPRT_MASK | MMA8451Q_CTRL_REG3_WAKE_TRANS_MASK, reg3);
+	(void) UpdateRegister(MMA8451Q_CTRL_REG2, MMA8451Q_CTRL_REG2_SLPE_MASK | MMA8451Q_CTRL_REG2_SMODS_MASK,
+			AutoSleep ? (MMA8451Q_CTRL_REG2_SLPE_MASK | MMA8451Q_CTRL_REG2_SMODS(CurrentOversampling)) : 0);
+	(void) UpdateRegister(MMA8451Q_CTRL_REG1, MMA8451Q_CTRL_REG1_ASLP_RATE_MASK, MMA8451Q_CTRL_REG1_ASLP_RATE(ACCEL_SLEEP_RATE));
+
 	/*Write the interrupt (or not)*/
-	I2C_Write(MMA8451Q_CTRL_REG4, reg4Tmp, bFALSE);
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_CTRL_REG4, reg4Tmp, ACCEL_I2C_TIMEOUT);
+
+	/*The FIFO mode has to go through disabled to change*/
+	(void) I2C_BlockingWrite(&Device, MMA8451Q_F_SETUP, 0, ACCEL_I2C_TIMEOUT);
+	if (fSetup)
+	{
+		(void) I2C_BlockingWrite(&Device, MMA8451Q_F_SETUP, fSetup, ACCEL_I2C_TIMEOUT);
+	}
 
 	/*Active on*/
 	SetActive(bTRUE);
@@ -257,6 +937,169 @@ TAccelMode Accel_GetMode()
 	return CurrentMode;
 }
 
+BOOL Accel_SetResolution(const TAccelResolution resolution)
+{
+	SetActive(bFALSE);
+	BOOL result = UpdateRegister(MMA8451Q_CTRL_REG1, MMA8451Q_CTRL_REG1_F_READ_MASK,
+			(resolution == ACCEL_RESOLUTION_14_BIT) ? 0 : MMA8451Q_CTRL_REG1_F_READ_MASK);
+	SetActive(bTRUE);
+	if (!result)
+	{
+		return bFALSE;
+	}
+
+	//A read already queued keeps the size it was queued with
+	CurrentResolution = resolution;
+	SampleSize = (resolution == ACCEL_RESOLUTION_14_BIT) ? 6 : 3;
+	return bTRUE;
+}
+
+TAccelResolution Accel_GetResolution()
+{
+	return CurrentResolution;
+}
+
+BOOL Accel_SetEvents(const uint8_t engines)
+{
+	if (engines & ~(ACCEL_EVENT_FREEFALL | ACCEL_EVENT_MOTION | ACCEL_EVENT_TRANSIENT | ACCEL_EVENT_TAP | ACCEL_EVENT_ORIENTATION))
+	{
+		return bFALSE;
+	}
+	EventEngines = engines;
+	if (CurrentMode == ACCEL_EVENT)
+	{
+		Accel_SetMode(ACCEL_EVENT);
+	}
+	return bTRUE;
+}
+
+uint8_t Accel_GetEvents()
+{
+	return EventEngines;
+}
+
+void Accel_SetAcquisition(const TAccelAcquisition acquisition)
+{
+	Acquisition = acquisition;
+}
+
+TAccelAcquisition Accel_GetAcquisition()
+{
+	return Acquisition;
+}
+
+void Accel_SetAutoSleep(const BOOL enable)
+{
+	EnterCritical();
+	AutoSleep = enable;
+	PowerState = ACCEL_POWER_WAKE;
+	PowerStateSince = OS_TimeGet();
+	LatencyPending = bFALSE;
+	ExitCritical();
+	//Applied along with the mode
+	Accel_SetMode(CurrentMode);
+}
+
+BOOL Accel_GetAutoSleep()
+{
+	return AutoSleep;
+}
+
+TAccelPowerState Accel_GetPowerState()
+{
+	return PowerState;
+}
+
+void Accel_GetSleepStatistics(TAccelSleepStatistics * const statistics)
+{
+	EnterCritical();
+	uint32_t now = OS_TimeGet();
+	SleepStatistics.ticks[PowerState] += now - PowerStateSince;
+	PowerStateSince = now;
+	*statistics = SleepStatistics;
+	for (uint8_t state = 0; state < 2; state++)
+	{
+		SleepStatistics.interrupts[state] = 0;
+		SleepStatistics.ticks[state] = 0;
+	}
+	ExitCritical();
+}
+
+BOOL Accel_SetDataRate(const TAccelDataRate rate)
+{
+	if (rate > ACCEL_DATA_RATE_1_56_HZ)
+	{
+		return bFALSE;
+	}
+	SetActive(bFALSE);
+	BOOL result = UpdateRegister(MMA8451Q_CTRL_REG1, MMA8451Q_CTRL_REG1_DR_MASK, MMA8451Q_CTRL_REG1_DR(rate));
+	SetActive(bTRUE);
+	if (result)
+	{
+		CurrentDataRate = rate;
+	}
+	return result;
+}
+
+TAccelDataRate Accel_GetDataRate()
+{
+	return CurrentDataRate;
+}
+
+uint32_t Accel_GetSamplePeriod()
+{
+	//The sleep rate only ever slows it down
+	if ((PowerState == ACCEL_POWER_SLEEP) && (SleepPeriods[ACCEL_SLEEP_RATE] > SamplePeriods[CurrentDataRate]))
+	{
+		return SleepPeriods[ACCEL_SLEEP_RATE];
+	}
+	return SamplePeriods[CurrentDataRate];
+}
+
+BOOL Accel_SetRange(const TAccelRange range)
+{
+	if (range > ACCEL_RANGE_8G)
+	{
+		return bFALSE;
+	}
+	SetActive(bFALSE);
+	BOOL result = UpdateRegister(MMA8451Q_XYZ_DATA_CFG, MMA8451Q_XYZ_DATA_CFG_FS_MASK, MMA8451Q_XYZ_DATA_CFG_FS(range))
+			&& UpdateRegister(MMA8451Q_CTRL_REG1, MMA8451Q_CTRL_REG1_LNOISE_MASK,
+					(range == ACCEL_RANGE_8G) ? 0 : MMA8451Q_CTRL_REG1_LNOISE_MASK);
+	SetActive(bTRUE);
+	if (result)
+	{
+		CurrentRange = range;
+	}
+	return result;
+}
+
+TAccelRange Accel_GetRange()
+{
+	return CurrentRange;
+}
+
+BOOL Accel_SetOversampling(const TAccelOversampling oversampling)
+{
+	if (oversampling > ACCEL_OVERSAMPLING_LOW_POWER)
+	{
+		return bFALSE;
+	}
+	SetActive(bFALSE);
+	BOOL result = UpdateRegister(MMA8451Q_CTRL_REG2, MMA8451Q_CTRL_REG2_MODS_MASK, MMA8451Q_CTRL_REG2_MODS(oversampling));
+	SetActive(bTRUE);
+	if (result)
+	{
+		CurrentOversampling = oversampling;
+	}
+	return result;
+}
+
+TAccelOversampling Accel_GetOversampling()
+{
+	return CurrentOversampling;
+}
+
 void __attribute__ ((interrupt)) AccelDataReady_ISR(void)
 {
 	OS_ISREnter();
@@ -270,6 +1113,20 @@ void __attribute__ ((interrupt)) AccelDataReady_ISR(void)
 	//clear the interrupt on the k70
 	PORTB_PCR7 |= PORT_PCR_ISF_MASK;
 
+	InterruptCycles = BENCH_CYCLES();
+	SleepStatistics.interrupts[PowerState]++;
+	if (LatencyPending)
+	{
+		LatencyPending = bFALSE;
+		SleepStatistics.latency[PowerState] = InterruptCycles - SwitchCycles;
+	}
+
+	//The source registers are read later, the event happened now
+	if (CurrentMode == ACCEL_EVENT)
+	{
+		EventTime = OS_TimeGet();
+	}
+
 	//clear the interrupt on the mma by reading the data.
 	(DataCallback)(DataCallbackArgument);
 	OS_ISRExit();
@@ -20,9 +20,151 @@
 typedef enum
 {
   ACCEL_POLL,
-  ACCEL_INT
+  ACCEL_INT,
+  ACCEL_FIFO,
+  ACCEL_EVENT
 } TAccelMode;
 
+/*!
+ * @brief Embedded detection engines used in ACCEL_EVENT mode.
+ *
+ * FREEFALL and MOTION share one engine, MOTION wins if both are set.
+ */
+#define ACCEL_EVENT_FREEFALL    0x01
+#define ACCEL_EVENT_MOTION      0x02
+#define ACCEL_EVENT_TRANSIENT   0x04
+#define ACCEL_EVENT_TAP         0x08
+#define ACCEL_EVENT_ORIENTATION 0x10
+
+/*!
+ * @brief Most events raised by one interrupt, one from each engine.
+ */
+#define ACCEL_EVENT_MAX 4
+
+/*!
+ * @brief The events read after one interrupt.
+ */
+typedef struct
+{
+  uint32_t time;                  /*!< OS_TimeGet when the interrupt was taken. */
+  uint8_t count;                  /*!< Number of events read. */
+  struct
+  {
+    uint8_t engine;               /*!< The ACCEL_EVENT_* engine which fired. */
+    uint8_t source;               /*!< The engine's source register (axes, polarity, orientation). */
+  } events[ACCEL_EVENT_MAX];
+} TAccelEvents;
+
+/*!
+ * @brief Bits of each sample read from the accelerometer.
+ */
+typedef enum
+{
+  ACCEL_RESOLUTION_8_BIT,   /*!< Only the MSB registers are read (F_READ). */
+  ACCEL_RESOLUTION_14_BIT   /*!< The MSB and LSB registers are read. */
+} TAccelResolution;
+
+/*!
+ * @brief Output data rates, the values are the CTRL_REG1 DR field.
+ */
+typedef enum
+{
+  ACCEL_DATA_RATE_800_HZ,
+  ACCEL_DATA_RATE_400_HZ,
+  ACCEL_DATA_RATE_200_HZ,
+  ACCEL_DATA_RATE_100_HZ,
+  ACCEL_DATA_RATE_50_HZ,
+  ACCEL_DATA_RATE_12_5_HZ,
+  ACCEL_DATA_RATE_6_25_HZ,
+  ACCEL_DATA_RATE_1_56_HZ
+} TAccelDataRate;
+
+/*!
+ * @brief Full-scale ranges, the values are the XYZ_DATA_CFG FS field.
+ */
+typedef enum
+{
+  ACCEL_RANGE_2G,
+  ACCEL_RANGE_4G,
+  ACCEL_RANGE_8G
+} TAccelRange;
+
+/*!
+ * @brief Oversampling modes, the values are the CTRL_REG2 MODS field.
+ */
+typedef enum
+{
+  ACCEL_OVERSAMPLING_NORMAL,
+  ACCEL_OVERSAMPLING_LOW_NOISE_LOW_POWER,
+  ACCEL_OVERSAMPLING_HIGH_RESOLUTION,
+  ACCEL_OVERSAMPLING_LOW_POWER
+} TAccelOversampling;
+
+/*!
+ * @brief How the owner of the callbacks starts a read after the data ready callback.
+ */
+typedef enum
+{
+  ACCEL_ACQUISITION_THREAD,   /*!< The callback wakes a thread, which queues the read. */
+  ACCEL_ACQUISITION_DIRECT    /*!< The read is queued from the callback, in the interrupt. */
+} TAccelAcquisition;
+
+/*!
+ * @brief Power state of the accelerometer while auto-sleep is on.
+ */
+typedef enum
+{
+  ACCEL_POWER_SLEEP,    /*!< Idle, sampling at the sleep rate. */
+  ACCEL_POWER_WAKE      /*!< Sampling at the output data rate. */
+} TAccelPowerState;
+
+/*!
+ * @brief Effect of auto-sleep, indexed by TAccelPowerState.
+ */
+typedef struct
+{
+  uint32_t interrupts[2];   /*!< Accelerometer interrupts taken in each state. */
+  uint32_t ticks[2];        /*!< OS ticks spent in each state. */
+  uint32_t latency[2];      /*!< Cycles from the interrupt reporting the last switch into each state to the next interrupt. */
+} TAccelSleepStatistics;
+
+/*!
+ * @brief Index of each axis in a sample.
+ */
+#define ACCEL_X 0
+#define ACCEL_Y 1
+#define ACCEL_Z 2
+
+/*!
+ * @brief One reading of the 3 axes.
+ *
+ * The axes are signed 14-bit counts whatever the resolution,
+ * in ACCEL_RESOLUTION_8_BIT the lower 6 bits are 0.
+ */
+typedef struct
+{
+  int16_t axes[3];    /*!< X, Y and Z, indexed with ACCEL_X, ACCEL_Y and ACCEL_Z. */
+} TAccelSample;
+
+/*!
+ * @brief Depth of the accelerometer's FIFO.
+ */
+#define ACCEL_FIFO_SIZE 32
+
+/*!
+ * @brief Samples in the FIFO which raise the data ready interrupt in ACCEL_FIFO mode.
+ */
+#define ACCEL_FIFO_WATERMARK 16
+
+/*!
+ * @brief Samples read out of the FIFO.
+ */
+typedef struct
+{
+  uint8_t count;                          /*!< Number of samples read. */
+  TAccelSample samples[ACCEL_FIFO_SIZE];  /*!< The samples, oldest first. */
+} TAccelFIFO;
+
 typedef struct
 {
   uint32_t moduleClk;				/*!< The module clock rate in Hz. */
@@ -36,16 +178,65 @@ typedef struct
  *
  *  @param accelSetup is a pointer to an accelerometer setup structure.
  *  @return BOOL - TRUE if the accelerometer module was successfully initialized.
+ *  @note Sleeps on the I2C, so must be called from a thread after OS_Start.
  */
 BOOL Accel_Init(const TAccelSetup* const accelSetup);
 
 /*! @brief Reads X, Y and Z accelerations.
- *  @param data is a an array of 3 bytes where the X, Y and Z data are stored.
+ *
+ *  The read complete callback is called once the sample is in.
+ *  @param sample is where the X, Y and Z data are stored.
+ */
+void Accel_ReadXYZ(TAccelSample * const sample);
+
+/*! @brief Reads all the samples buffered in the accelerometer's FIFO.
+ *
+ *  The status and the samples are read in 2 back-to-back transfers,
+ *  the read complete callback is called once the samples are in, with none if either fails.
+ *  @param fifo is where the samples are stored.
+ *  @return BOOL - TRUE if the read was queued.
+ *  @note Only valid in ACCEL_FIFO mode.
+ */
+BOOL Accel_ReadFIFO(TAccelFIFO * const fifo);
+
+/*! @brief Reads the events raised by the last interrupt.
+ *
+ *  The interrupt source is read, then the source register of each engine which fired,
+ *  which clears the interrupt. The read complete callback is called once they are in,
+ *  without the events whose source register couldn't be read.
+ *  @param events is where the events are stored.
+ *  @return BOOL - TRUE if the read was queued.
+ *  @note Only valid in ACCEL_EVENT mode.
+ */
+BOOL Accel_ReadEvents(TAccelEvents * const events);
+
+/*!
+ * @brief Get whether the accelerometer is holding its interrupt line.
+ *
+ * The data ready interrupt is on the falling edge, a source left unread holds the line and raises no more.
+ * @return BOOL - TRUE if the line is asserted.
+ */
+BOOL Accel_InterruptAsserted();
+
+/*! @brief Choose the engines used in ACCEL_EVENT mode.
+ *
+ *  The engines are configured when ACCEL_EVENT mode is entered,
+ *  if it is the current mode it is entered again.
+ *  @param engines The ACCEL_EVENT_* engines to enable.
+ *  @return BOOL - TRUE if the engines were accepted.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+BOOL Accel_SetEvents(const uint8_t engines);
+
+/*!
+ * @brief Get the engines used in ACCEL_EVENT mode.
+ * @return uint8_t - The ACCEL_EVENT_* engines.
  */
-void Accel_ReadXYZ(uint8_t data[3]);
+uint8_t Accel_GetEvents();
 
 /*! @brief Set the mode of the accelerometer.
- *  @param mode specifies either polled or interrupt driven operation.
+ *  @param mode specifies polled, interrupt driven, FIFO watermark driven or event driven operation.
+ *  @note Sleeps on the I2C, so must be called from a thread.
  */
 void Accel_SetMode(const TAccelMode mode);
 
@@ -55,6 +246,108 @@ void Accel_SetMode(const TAccelMode mode);
  */
 TAccelMode Accel_GetMode();
 
+/*! @brief Set the resolution of the samples.
+ *  @param resolution 8 bits for the smallest reads, 14 bits for the full output.
+ *  @return BOOL - TRUE if the resolution was changed.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+BOOL Accel_SetResolution(const TAccelResolution resolution);
+
+/*!
+ * @brief Get the current resolution of the samples.
+ * @return TAccelResolution
+ */
+TAccelResolution Accel_GetResolution();
+
+/*! @brief Set the output data rate.
+ *  @param rate The new data rate.
+ *  @return BOOL - TRUE if the data rate was changed.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+BOOL Accel_SetDataRate(const TAccelDataRate rate);
+
+/*!
+ * @brief Get the current output data rate.
+ * @return TAccelDataRate
+ */
+TAccelDataRate Accel_GetDataRate();
+
+/*!
+ * @brief Get the time between samples at the current output data rate.
+ * @return uint32_t - The period in microseconds.
+ */
+uint32_t Accel_GetSamplePeriod();
+
+/*! @brief Set the full-scale range.
+ *
+ *  The low noise mode is only available up to 4g, it is turned off in ACCEL_RANGE_8G.
+ *  @param range The new range.
+ *  @return BOOL - TRUE if the range was changed.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+BOOL Accel_SetRange(const TAccelRange range);
+
+/*!
+ * @brief Get the current full-scale range.
+ * @return TAccelRange
+ */
+TAccelRange Accel_GetRange();
+
+/*! @brief Set the oversampling mode.
+ *  @param oversampling The new oversampling mode.
+ *  @return BOOL - TRUE if the mode was changed.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+BOOL Accel_SetOversampling(const TAccelOversampling oversampling);
+
+/*!
+ * @brief Get the current oversampling mode.
+ * @return TAccelOversampling
+ */
+TAccelOversampling Accel_GetOversampling();
+
+/*! @brief Choose how reads follow the data ready callback.
+ *
+ *  The read functions don't block, so they can be called from the data ready callback.
+ *  @param acquisition The acquisition mode.
+ */
+void Accel_SetAcquisition(const TAccelAcquisition acquisition);
+
+/*!
+ * @brief Get how reads follow the data ready callback.
+ * @return TAccelAcquisition
+ */
+TAccelAcquisition Accel_GetAcquisition();
+
+/*! @brief Turn auto-sleep on or off.
+ *
+ *  When on, the accelerometer drops to the sleep rate after a period without motion,
+ *  and returns to the output data rate on a transient (or on any engine in ACCEL_EVENT mode).
+ *  Each switch raises the data ready interrupt.
+ *  @param enable bTRUE to turn auto-sleep on.
+ *  @note Sleeps on the I2C, so must be called from a thread.
+ */
+void Accel_SetAutoSleep(const BOOL enable);
+
+/*!
+ * @brief Get whether auto-sleep is on.
+ * @return BOOL - TRUE if auto-sleep is on.
+ */
+BOOL Accel_GetAutoSleep();
+
+/*!
+ * @brief Get the power state as of the last read.
+ * @return TAccelPowerState
+ */
+TAccelPowerState Accel_GetPowerState();
+
+/*! @brief Reads and clears the auto-sleep statistics.
+ *
+ *  The latencies are kept, they are measured in the interrupt driven modes.
+ *  @param statistics is filled with the interrupts and time in each state since the last call.
+ */
+void Accel_GetSleepStatistics(TAccelSleepStatistics * const statistics);
+
 /*! @brief Interrupt service routine for the accelerometer.
  *
  *  The accelerometer has data ready.
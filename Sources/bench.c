@@ -0,0 +1,712 @@
+/*! @file
+ *
+ *  @brief Implementation of the cycle count benchmarks.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-08
+ */
+/*!
+**  @addtogroup bench_module Benchmark module documentation
+**  @{
+*/
+#include "bench.h"
+
+#include "accel.h"
+#include "cmd.h"
+#include "dsp.h"
+#include "fft.h"
+#include "fixed.h"
+#include "Flash.h"
+#include "FMC.h"
+#include "I2C.h"
+#include "median.h"
+#include "packet.h"
+#include "random.h"
+#include "report.h"
+#include "samples.h"
+#include "tilt.h"
+#include "timer.h"
+#include "UART.h"
+#include "update.h"
+
+#include "Cpu.h"
+
+#include <math.h>
+
+/*!
+ * @brief Enables the DWT and ITM blocks.
+ */
+#define DEMCR_TRCENA_MASK 0x01000000LU
+
+/*!
+ * @brief Enables the DWT cycle counter.
+ */
+#define DWT_CTRL_CYCCNTENA_MASK 0x1LU
+
+/*!
+ * @brief Pending bit of the FTM0 interrupt (IRQ 62) in NVICISPR1.
+ */
+#define FTM0_IRQ_MASK (1LU << (62 - 32))
+
+/*!
+ * @brief Pending bit of the UART2 status interrupt (IRQ 49) in NVICISPR1.
+ */
+#define UART2_IRQ_MASK (1LU << (49 - 32))
+
+/*!
+ * @brief Sector erased by BENCH_UART_ERASE, the top of the image area of the inactive block.
+ */
+#define BENCH_ERASE_SECTOR (FLASH_INACTIVE_BLOCK_START + UPDATE_IMAGE_MAX_SIZE - FLASH_SECTOR_SIZE)
+
+/*!
+ * @brief Cycles between the BENCH_UART_ERASE measurements during the erase (0.5 ms).
+ */
+#define BENCH_ERASE_GAP (CPU_CORE_CLK_HZ / 2000)
+
+/*!
+ * @brief Slave address of the BENCH_I2C burst (the accelerometer).
+ */
+#define BENCH_I2C_ADDRESS 0x1D
+
+/*!
+ * @brief Baud rate of the BENCH_I2C burst.
+ */
+#define BENCH_I2C_BAUD_RATE 100000
+
+/*!
+ * @brief First register of the BENCH_I2C burst (OUT_X_MSB on the accelerometer).
+ */
+#define BENCH_I2C_REGISTER 0x01
+
+/*!
+ * @brief OS ticks to wait for a BENCH_I2C burst.
+ */
+#define BENCH_I2C_TIMEOUT 100
+
+/*!
+ * @brief Destination of the BENCH_I2C bursts.
+ */
+static uint8_t BurstBuffer[BENCH_I2C_BYTES];
+
+/*!
+ * @brief FMC configurations compared by BENCH_FMC.
+ */
+const static TFMCSetup FMCConfigs[] = {
+		//Everything off, every fetch goes to the Flash array
+		{ 0x00, bFALSE, bFALSE, bFALSE, bFALSE, bFALSE, FMC_CACHE_WAYS_SHARED },
+		//Speculation only
+		{ 0xFF, bTRUE, bTRUE, bTRUE, bFALSE, bFALSE, FMC_CACHE_WAYS_SHARED },
+		//Cache only
+		{ 0x00, bFALSE, bFALSE, bFALSE, bTRUE, bTRUE, FMC_CACHE_WAYS_SHARED },
+		//Cache and speculation (the reset state)
+		{ 0xFF, bTRUE, bTRUE, bTRUE, bTRUE, bTRUE, FMC_CACHE_WAYS_SHARED },
+		//Cache and speculation, 3 ways kept for instructions
+		{ 0xFF, bTRUE, bTRUE, bTRUE, bTRUE, bTRUE, FMC_CACHE_WAYS_IFETCH_3_DATA_1 } };
+
+/*!
+ * @brief Count of FMC configurations.
+ */
+#define FMC_CONFIG_COUNT (sizeof(FMCConfigs) / sizeof(FMCConfigs[0]))
+
+/*!
+ * @brief Saturate a cycle count into 16 bits.
+ * @param cycles The cycle count.
+ * @return The saturated count.
+ */
+static uint16_t Saturate16(const uint32_t cycles)
+{
+	return (cycles > 0xFFFF) ? 0xFFFF : (uint16_t) cycles;
+}
+
+/*!
+ * @brief Time Packet_Get over one whole packet.
+ *
+ * The packet is placed in the receive FIFO with interrupts off,
+ * so the receive thread can't mix real bytes in.
+ * @return The number of cycles.
+ */
+static uint32_t TimePacketParse()
+{
+	//Packet_Get overwrites these, the acknowledgement still needs them
+	uint8_t command = Packet_Command;
+	uint8_t parameter1 = Packet_Parameter1;
+	uint8_t parameter2 = Packet_Parameter2;
+	uint8_t parameter3 = Packet_Parameter3;
+
+	const uint8_t packet[5] = { 0x00, 0x01, 0x02, 0x03, 0x00 ^ 0x01 ^ 0x02 ^ 0x03 };
+
+	EnterCritical();
+	for (size_t i = 0; i < sizeof(packet); i++)
+	{
+		(void) FIFO_Put(&RxFIFO, packet[i]);
+	}
+	uint32_t start = BENCH_CYCLES();
+	for (size_t i = 0; i < sizeof(packet); i++)
+	{
+		(void) Packet_Get();
+	}
+	uint32_t cycles = BENCH_CYCLES() - start;
+	ExitCritical();
+
+	Packet_Command = command;
+	Packet_Parameter1 = parameter1;
+	Packet_Parameter2 = parameter2;
+	Packet_Parameter3 = parameter3;
+	return cycles;
+}
+
+/*!
+ * @brief Time entering and leaving the FTM0 ISR.
+ *
+ * The interrupt is pended with no channel flag set, so the ISR only scans the channels.
+ * @return The number of cycles.
+ */
+static uint32_t TimeISR()
+{
+	uint32_t start = BENCH_CYCLES();
+	NVICISPR1 = FTM0_IRQ_MASK;
+	__asm ("DSB");
+	__asm ("ISB");
+	return BENCH_CYCLES() - start;
+}
+
+/*!
+ * @brief Time entering, running and leaving the UART ISR.
+ *
+ * The interrupt is pended with no byte received, the transmit semaphore may be signalled.
+ * @return The number of cycles.
+ */
+static uint32_t TimeUARTISR()
+{
+	uint32_t start = BENCH_CYCLES();
+	NVICISPR1 = UART2_IRQ_MASK;
+	__asm ("DSB");
+	__asm ("ISB");
+	return BENCH_CYCLES() - start;
+}
+
+/*!
+ * @brief Run the packet parse and ISR measurements under each FMC configuration.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchFMC()
+{
+	//Needs room in the FIFO and no real packet in the way
+	if (RxFIFO.NbBytes != 0)
+	{
+		return bFALSE;
+	}
+
+	TFMCSetup original;
+	FMC_Get(&original);
+
+	for (uint8_t config = 0; config < FMC_CONFIG_COUNT; config++)
+	{
+		(void) FMC_Set(&FMCConfigs[config]);
+
+		//Minimum of the runs, the first run also warms whatever is enabled
+		uint32_t parse = UINT32_MAX;
+		uint32_t isr = UINT32_MAX;
+		for (uint8_t run = 0; run < BENCH_RUNS; run++)
+		{
+			uint32_t cycles = TimePacketParse();
+			parse = (cycles < parse) ? cycles : parse;
+			cycles = TimeISR();
+			isr = (cycles < isr) ? cycles : isr;
+		}
+
+		(void) CMD_SendBenchmark((config << 4) | BENCH_FMC_PACKET_PARSE, Saturate16(parse));
+		(void) CMD_SendBenchmark((config << 4) | BENCH_FMC_ISR, Saturate16(isr));
+	}
+
+	(void) FMC_Set(&original);
+	return bTRUE;
+}
+
+/*!
+ * @brief Compare the interrupt work of a burst read in each receive mode.
+ *
+ * Other I2C traffic during a run is counted too, the minimum of the runs is reported.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchI2C()
+{
+	const TI2CReceiveMode modes[] = { I2C_RECEIVE_INTERRUPT, I2C_RECEIVE_DMA };
+
+	//A handle of our own, shares the bus with the accelerometer module's.
+	//Set up once, a cancelled read of an earlier run may still be counted in its queued entries.
+	static TI2CDevice device;
+	static BOOL deviceReady = bFALSE;
+	if (!deviceReady)
+	{
+		if (!I2C_DeviceInit(&device, BENCH_I2C_ADDRESS, BENCH_I2C_BAUD_RATE, 0))
+		{
+			return bFALSE;
+		}
+		deviceReady = bTRUE;
+	}
+
+	for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+	{
+		I2C_SetReceiveMode(modes[m]);
+
+		TI2CStatistics statistics;
+		uint32_t interrupts = UINT32_MAX;
+		uint32_t cycles = UINT32_MAX;
+		for (uint8_t run = 0; run < BENCH_RUNS; run++)
+		{
+			I2C_GetStatistics(&statistics);
+			if (!I2C_BlockingRead(&device, BENCH_I2C_REGISTER, BurstBuffer, BENCH_I2C_BYTES, BENCH_I2C_TIMEOUT))
+			{
+				I2C_SetReceiveMode(I2C_RECEIVE_DMA);
+				return bFALSE;
+			}
+			I2C_GetStatistics(&statistics);
+			interrupts = (statistics.interrupts < interrupts) ? statistics.interrupts : interrupts;
+			cycles = (statistics.cycles < cycles) ? statistics.cycles : cycles;
+		}
+
+		(void) CMD_SendBenchmark((modes[m] << 4) | BENCH_I2C_INTERRUPTS, Saturate16(interrupts));
+		(void) CMD_SendBenchmark((modes[m] << 4) | BENCH_I2C_CYCLES_PER_BYTE, Saturate16(cycles / BENCH_I2C_BYTES));
+	}
+
+	I2C_SetReceiveMode(I2C_RECEIVE_DMA);
+	return bTRUE;
+}
+
+/*!
+ * @brief Report the accelerometer auto-sleep statistics.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchAccelSleep()
+{
+	if (!Accel_GetAutoSleep())
+	{
+		return bFALSE;
+	}
+
+	TAccelSleepStatistics statistics;
+	Accel_GetSleepStatistics(&statistics);
+
+	const TAccelPowerState states[] = { ACCEL_POWER_SLEEP, ACCEL_POWER_WAKE };
+	for (size_t i = 0; i < sizeof(states) / sizeof(states[0]); i++)
+	{
+		TAccelPowerState state = states[i];
+		(void) CMD_SendBenchmark((state << 4) | BENCH_SLEEP_INTERRUPTS, Saturate16(statistics.interrupts[state]));
+		(void) CMD_SendBenchmark((state << 4) | BENCH_SLEEP_TICKS, Saturate16(statistics.ticks[state]));
+		(void) CMD_SendBenchmark((state << 4) | BENCH_SLEEP_LATENCY, Saturate16(statistics.latency[state] / (CPU_CORE_CLK_HZ / 10000)));
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Report the accelerometer latency.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchAccelLatency()
+{
+	TSampleLatency latency;
+	Samples_GetLatency(&latency);
+	if (latency.count == 0)
+	{
+		return bFALSE;
+	}
+
+	const uint32_t cyclesPerUs = CPU_CORE_CLK_HZ / 1000000;
+	uint8_t acquisition = (uint8_t) Accel_GetAcquisition() << 4;
+	(void) CMD_SendBenchmark(acquisition | BENCH_LATENCY_MIN, Saturate16(latency.min / cyclesPerUs));
+	(void) CMD_SendBenchmark(acquisition | BENCH_LATENCY_MEAN, Saturate16(latency.total / latency.count / cyclesPerUs));
+	(void) CMD_SendBenchmark(acquisition | BENCH_LATENCY_MAX, Saturate16(latency.max / cyclesPerUs));
+	return bTRUE;
+}
+
+/*!
+ * @brief The median of a window by sorting a copy of it, the naive filter.
+ * @param window The window.
+ * @param length The number of values in it.
+ * @return The median.
+ */
+static int16_t SortMedian(const int16_t * const window, const uint8_t length)
+{
+	int16_t sorted[MEDIAN_WINDOW_MAX];
+	for (uint8_t i = 0; i < length; i++)
+	{
+		int16_t value = window[i];
+		uint8_t j = i;
+		for (; (j > 0) && (sorted[j - 1] > value); j--)
+		{
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = value;
+	}
+	return sorted[length / 2];
+}
+
+/*!
+ * @brief Compare the streaming median filter with sorting each window.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchMedian()
+{
+	static TMedianFilter filter;
+	static int16_t values[BENCH_MEDIAN_UPDATES];
+	static int16_t window[MEDIAN_WINDOW_MAX];
+	const uint8_t windows[] = BENCH_MEDIAN_WINDOWS;
+
+	for (size_t i = 0; i < BENCH_MEDIAN_UPDATES; i++)
+	{
+		values[i] = (int16_t) Random_Generate();
+	}
+
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+	{
+		uint8_t length = windows[w];
+		if (!Median_Init(&filter, length))
+		{
+			return bFALSE;
+		}
+		//Both start from a full window
+		for (uint8_t i = 0; i < length; i++)
+		{
+			window[i] = values[i];
+			(void) Median_Update(&filter, values[i]);
+		}
+
+		volatile int16_t median;
+		uint32_t start = BENCH_CYCLES();
+		for (size_t i = 0; i < BENCH_MEDIAN_UPDATES; i++)
+		{
+			median = Median_Update(&filter, values[i]);
+		}
+		uint32_t streaming = BENCH_CYCLES() - start;
+
+		uint8_t next = 0;
+		start = BENCH_CYCLES();
+		for (size_t i = 0; i < BENCH_MEDIAN_UPDATES; i++)
+		{
+			window[next] = values[i];
+			next = (next + 1 == length) ? 0 : next + 1;
+			median = SortMedian(window, length);
+		}
+		uint32_t sort = BENCH_CYCLES() - start;
+		(void) median;
+
+		(void) CMD_SendBenchmark((BENCH_MEDIAN_STREAMING << 6) | length, Saturate16(streaming / BENCH_MEDIAN_UPDATES));
+		(void) CMD_SendBenchmark((BENCH_MEDIAN_SORT << 6) | length, Saturate16(sort / BENCH_MEDIAN_UPDATES));
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Compare the packed median of 3 with the scalar one.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchMedian3()
+{
+	static TAccelSample samples[BENCH_MEDIAN_UPDATES];
+	static TAccelSample filtered[BENCH_MEDIAN_UPDATES];
+	static TAccelSample packedFiltered[BENCH_MEDIAN_UPDATES];
+
+	for (size_t i = 0; i < BENCH_MEDIAN_UPDATES; i++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			samples[i].axes[axis] = (int16_t) Random_Generate();
+		}
+	}
+
+	uint32_t start = BENCH_CYCLES();
+	for (size_t i = 2; i < BENCH_MEDIAN_UPDATES; i++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			filtered[i].axes[axis] = Median_Filter3Int16(samples[i - 2].axes[axis], samples[i - 1].axes[axis], samples[i].axes[axis]);
+		}
+	}
+	uint32_t scalar = BENCH_CYCLES() - start;
+
+	start = BENCH_CYCLES();
+	for (size_t i = 2; i < BENCH_MEDIAN_UPDATES; i++)
+	{
+		const TAccelSample * const s = &samples[i - 2];
+		uint32_t xy = Median_Filter3Packed(MEDIAN_PACK(s[0].axes[ACCEL_X], s[0].axes[ACCEL_Y]),
+				MEDIAN_PACK(s[1].axes[ACCEL_X], s[1].axes[ACCEL_Y]),
+				MEDIAN_PACK(s[2].axes[ACCEL_X], s[2].axes[ACCEL_Y]));
+		uint32_t z = Median_Filter3Packed(MEDIAN_PACK(s[0].axes[ACCEL_Z], 0),
+				MEDIAN_PACK(s[1].axes[ACCEL_Z], 0),
+				MEDIAN_PACK(s[2].axes[ACCEL_Z], 0));
+		packedFiltered[i].axes[ACCEL_X] = MEDIAN_UNPACK_LOW(xy);
+		packedFiltered[i].axes[ACCEL_Y] = MEDIAN_UNPACK_HIGH(xy);
+		packedFiltered[i].axes[ACCEL_Z] = MEDIAN_UNPACK_LOW(z);
+	}
+	uint32_t packed = BENCH_CYCLES() - start;
+
+	//Both ways have to agree
+	for (size_t i = 2; i < BENCH_MEDIAN_UPDATES; i++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			if (filtered[i].axes[axis] != packedFiltered[i].axes[axis])
+			{
+				return bFALSE;
+			}
+		}
+	}
+
+	(void) CMD_SendBenchmark(BENCH_MEDIAN3_SCALAR, Saturate16(scalar / (BENCH_MEDIAN_UPDATES - 2)));
+	(void) CMD_SendBenchmark(BENCH_MEDIAN3_PACKED, Saturate16(packed / (BENCH_MEDIAN_UPDATES - 2)));
+	return bTRUE;
+}
+
+/*!
+ * @brief Report the cycles spent in each filter pipeline stage.
+ * @return bTRUE if any stage ran.
+ */
+static BOOL BenchDsp()
+{
+	TDspStatistics statistics;
+	Dsp_GetStatistics(&statistics);
+
+	BOOL ran = bFALSE;
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		if (statistics.samples[i])
+		{
+			ran = bTRUE;
+			(void) CMD_SendBenchmark((i << 4) | (uint8_t) Dsp_GetStage(i), Saturate16(statistics.cycles[i] / statistics.samples[i]));
+		}
+	}
+	return ran;
+}
+
+/*!
+ * @brief Time the Hann window and real FFT at each size.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchFft()
+{
+	static int16_t frame[FFT_SIZE_MAX];
+	static uint16_t magnitudes[FFT_SIZE_MAX / 2 + 1];
+	const uint16_t sizes[] = BENCH_FFT_SIZES;
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		uint16_t size = sizes[i];
+		uint32_t cycles = UINT32_MAX;
+		for (uint8_t run = 0; run < BENCH_RUNS; run++)
+		{
+			//14-bit samples, like the accelerometer's
+			for (uint16_t n = 0; n < size; n++)
+			{
+				frame[n] = (int16_t) Random_Generate() >> 2;
+			}
+			uint32_t start = BENCH_CYCLES();
+			Fft_HannWindow(frame, size, 2);
+			if (!Fft_RealMagnitudes(frame, size, magnitudes))
+			{
+				return bFALSE;
+			}
+			uint32_t time = BENCH_CYCLES() - start;
+			cycles = (time < cycles) ? time : cycles;
+		}
+
+		uint8_t sizeLog2 = 0;
+		for (uint16_t s = size; s > 1; s >>= 1)
+		{
+			sizeLog2++;
+		}
+		(void) CMD_SendBenchmark((sizeLog2 << 4) | BENCH_FFT_MICROSECONDS, Saturate16(cycles / (CPU_CORE_CLK_HZ / 1000000)));
+		(void) CMD_SendBenchmark((sizeLog2 << 4) | BENCH_FFT_CYCLES_PER_SAMPLE, Saturate16(cycles / size));
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Report the poll mode samples checked and sent.
+ * @return bTRUE if any samples were checked.
+ */
+static BOOL BenchReport()
+{
+	TReportStatistics statistics;
+	Report_GetStatistics(&statistics);
+	if (statistics.samples == 0)
+	{
+		return bFALSE;
+	}
+	(void) CMD_SendBenchmark(BENCH_REPORT_SAMPLES, Saturate16(statistics.samples));
+	(void) CMD_SendBenchmark(BENCH_REPORT_SENT, Saturate16(statistics.sent));
+	(void) CMD_SendBenchmark(BENCH_REPORT_HEARTBEATS, Saturate16(statistics.heartbeats));
+	return bTRUE;
+}
+
+/*!
+ * @brief Compare the fixed-point tilt angles with libm floats.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchTilt()
+{
+	static TAccelSample samples[BENCH_TILT_SAMPLES];
+	static TTilt angles[BENCH_TILT_SAMPLES];
+	static float pitches[BENCH_TILT_SAMPLES];
+	static float rolls[BENCH_TILT_SAMPLES];
+
+	//14-bit samples pointing every way
+	for (size_t i = 0; i < BENCH_TILT_SAMPLES; i++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			samples[i].axes[axis] = (int16_t) Random_Generate() >> 2;
+		}
+	}
+
+	uint32_t fixed = UINT32_MAX;
+	uint32_t floating = UINT32_MAX;
+	for (uint8_t run = 0; run < BENCH_RUNS; run++)
+	{
+		uint32_t start = BENCH_CYCLES();
+		for (size_t i = 0; i < BENCH_TILT_SAMPLES; i++)
+		{
+			Tilt_Compute(&samples[i], &angles[i]);
+		}
+		uint32_t time = BENCH_CYCLES() - start;
+		fixed = (time < fixed) ? time : fixed;
+
+		start = BENCH_CYCLES();
+		for (size_t i = 0; i < BENCH_TILT_SAMPLES; i++)
+		{
+			float x = samples[i].axes[ACCEL_X];
+			float y = samples[i].axes[ACCEL_Y];
+			float z = samples[i].axes[ACCEL_Z];
+			pitches[i] = atan2f(-x, sqrtf(y * y + z * z));
+			rolls[i] = atan2f(y, z);
+		}
+		time = BENCH_CYCLES() - start;
+		floating = (time < floating) ? time : floating;
+	}
+
+	//Largest difference in either angle, taken the short way round
+	const float turn = (float) FIXED_ANGLE_TURN / 6.28318531f;
+	float error = 0.0f;
+	for (size_t i = 0; i < BENCH_TILT_SAMPLES; i++)
+	{
+		float difference = fabsf((float) (int16_t) (angles[i].pitch - (int32_t) lrintf(pitches[i] * turn)));
+		error = (difference > error) ? difference : error;
+		difference = fabsf((float) (int16_t) (angles[i].roll - (int32_t) lrintf(rolls[i] * turn)));
+		error = (difference > error) ? difference : error;
+	}
+
+	(void) CMD_SendBenchmark(BENCH_TILT_FIXED, Saturate16(fixed / BENCH_TILT_SAMPLES));
+	(void) CMD_SendBenchmark(BENCH_TILT_FLOAT, Saturate16(floating / BENCH_TILT_SAMPLES));
+	(void) CMD_SendBenchmark(BENCH_TILT_ERROR, Saturate16((uint32_t) (error * 360000.0f / (float) FIXED_ANGLE_TURN + 0.5f)));
+	return bTRUE;
+}
+
+/*!
+ * @brief Report the time between the interrupts of each FTM channel.
+ * @return bTRUE if any channel had two interrupts.
+ */
+static BOOL BenchTimer()
+{
+	BOOL any = bFALSE;
+	for (uint8_t channel = 0; channel < BENCH_TIMER_CHANNELS; channel++)
+	{
+		TTimerJitter jitter;
+		Timer_GetJitter(channel, &jitter);
+		if (jitter.count == 0)
+		{
+			continue;
+		}
+		any = bTRUE;
+		(void) CMD_SendBenchmark((channel << 4) | BENCH_TIMER_MIN_INTERVAL, jitter.minInterval);
+		(void) CMD_SendBenchmark((channel << 4) | BENCH_TIMER_MAX_INTERVAL, jitter.maxInterval);
+	}
+	return any;
+}
+
+/*!
+ * @brief Compare the UART ISR with the Flash idle and during a sector erase.
+ * @return bTRUE if the benchmark ran.
+ */
+static BOOL BenchUARTErase()
+{
+	if (Update_IsReceiving())
+	{
+		return bFALSE;
+	}
+
+	uint32_t idle = 0;
+	for (uint8_t run = 0; run < BENCH_RUNS; run++)
+	{
+		uint32_t cycles = TimeUARTISR();
+		idle = (cycles > idle) ? cycles : idle;
+	}
+
+	if (!Flash_EraseSector(BENCH_ERASE_SECTOR, bFALSE))
+	{
+		return bFALSE;
+	}
+	//Spaced out so the transmit thread isn't flooded with signals
+	uint32_t erase = 0;
+	for (uint8_t run = 0; (run < BENCH_RUNS) && !(FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK); run++)
+	{
+		uint32_t cycles = TimeUARTISR();
+		erase = (cycles > erase) ? cycles : erase;
+		uint32_t start = BENCH_CYCLES();
+		while ((BENCH_CYCLES() - start < BENCH_ERASE_GAP) && !(FTFE_FSTAT & FTFE_FSTAT_CCIF_MASK))
+		{
+		}
+	}
+	if (!Flash_Wait())
+	{
+		return bFALSE;
+	}
+
+	(void) CMD_SendBenchmark(BENCH_UART_FLASH_IDLE, Saturate16(idle));
+	(void) CMD_SendBenchmark(BENCH_UART_FLASH_ERASE, Saturate16(erase));
+	return bTRUE;
+}
+
+BOOL Bench_Init()
+{
+	DEMCR |= DEMCR_TRCENA_MASK;
+	DWT_CYCCNT = 0;
+	DWT_CTRL |= DWT_CTRL_CYCCNTENA_MASK;
+	return bTRUE;
+}
+
+BOOL Bench_Run(const TBench bench)
+{
+	switch (bench)
+	{
+	case BENCH_FMC:
+		return BenchFMC();
+	case BENCH_I2C:
+		return BenchI2C();
+	case BENCH_ACCEL_SLEEP:
+		return BenchAccelSleep();
+	case BENCH_ACCEL_LATENCY:
+		return BenchAccelLatency();
+	case BENCH_MEDIAN:
+		return BenchMedian();
+	case BENCH_MEDIAN3:
+		return BenchMedian3();
+	case BENCH_DSP:
+		return BenchDsp();
+	case BENCH_FFT:
+		return BenchFft();
+	case BENCH_REPORT:
+		return BenchReport();
+	case BENCH_TILT:
+		return BenchTilt();
+	case BENCH_TIMER:
+		return BenchTimer();
+	case BENCH_UART_ERASE:
+		return BenchUARTErase();
+	default:
+		return bFALSE;
+	}
+}
+
+/*!
+** @}
+*/
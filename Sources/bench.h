@@ -0,0 +1,297 @@
+/*! @file
+ *
+ *  @brief Cycle count benchmarks run on the tower.
+ *
+ *  Uses the Cortex-M4 DWT cycle counter. Results are sent to the PC as packets.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-08
+ */
+/*!
+**  @addtogroup bench_module Benchmark module documentation
+**  @{
+*/
+#ifndef BENCH_H
+#define BENCH_H
+
+// new types
+#include "types.h"
+
+#include "MK70F12.h"
+
+/*!
+ * @brief Read the cycle counter.
+ */
+#define BENCH_CYCLES() (DWT_CYCCNT)
+
+/*!
+ * @brief Number of times each measurement is repeated, the minimum is reported.
+ */
+#define BENCH_RUNS 8
+
+/*!
+ * @brief The available benchmarks.
+ */
+typedef enum
+{
+  /*!
+   * Packet parse and ISR entry under each FMC configuration.
+   * For each configuration two results are sent:
+   *   parameter 1 is (configuration << 4) | BENCH_FMC_PACKET_PARSE or BENCH_FMC_ISR.
+   * The FMC configuration is restored afterwards.
+   * Must be run with no packet partially received.
+   */
+  BENCH_FMC = 1,
+  /*!
+   * Burst read of BENCH_I2C_BYTES from the accelerometer, with each receive mode.
+   * For each mode (TI2CReceiveMode) two results are sent:
+   *   parameter 1 is (mode << 4) | BENCH_I2C_INTERRUPTS or BENCH_I2C_CYCLES_PER_BYTE.
+   * DMA mode is restored afterwards.
+   */
+  BENCH_I2C = 2,
+  /*!
+   * Accelerometer auto-sleep statistics since the last run (Accel_GetSleepStatistics).
+   * For each power state (TAccelPowerState) three results are sent:
+   *   parameter 1 is (state << 4) | BENCH_SLEEP_INTERRUPTS, BENCH_SLEEP_TICKS or BENCH_SLEEP_LATENCY.
+   * The interrupt load of each state is interrupts / ticks.
+   */
+  BENCH_ACCEL_SLEEP = 3,
+  /*!
+   * Accelerometer latency since the last run (Samples_GetLatency),
+   * from the interrupt which triggered the read to the samples being in the transmit FIFO.
+   * Three results are sent, parameter 1 is (acquisition << 4) | BENCH_LATENCY_MIN, BENCH_LATENCY_MEAN or BENCH_LATENCY_MAX
+   * where acquisition is the current TAccelAcquisition.
+   */
+  BENCH_ACCEL_LATENCY = 4,
+  /*!
+   * Cycles per update of the streaming median filter against sorting a copy of the window,
+   * averaged over BENCH_MEDIAN_UPDATES random values, for each window in BENCH_MEDIAN_WINDOWS.
+   * Two results are sent for each window:
+   *   parameter 1 is (BENCH_MEDIAN_STREAMING or BENCH_MEDIAN_SORT << 6) | window.
+   */
+  BENCH_MEDIAN = 5,
+  /*!
+   * Cycles to median filter one sample (three axes) over a window of 3,
+   * averaged over BENCH_MEDIAN_UPDATES random samples.
+   * Parameter 1 is BENCH_MEDIAN3_SCALAR or BENCH_MEDIAN3_PACKED.
+   */
+  BENCH_MEDIAN3 = 6,
+  /*!
+   * Cycles per sample (all three axes) of each filter pipeline stage since the last run (Dsp_GetStatistics).
+   * A result is sent for each stage which ran, parameter 1 is (stage index << 4) | TDspStage.
+   * The budget of the whole pipeline is one sample period.
+   */
+  BENCH_DSP = 7,
+  /*!
+   * Hann window and real FFT magnitudes of random samples, for each size in BENCH_FFT_SIZES.
+   * Two results are sent for each size:
+   *   parameter 1 is (log2 size << 4) | BENCH_FFT_MICROSECONDS or BENCH_FFT_CYCLES_PER_SAMPLE.
+   */
+  BENCH_FFT = 8,
+  /*!
+   * Poll mode samples checked and sent since the last run (Report_GetStatistics),
+   * the traffic saved by the dead-band is 1 - sent / samples.
+   * Parameter 1 is BENCH_REPORT_SAMPLES, BENCH_REPORT_SENT or BENCH_REPORT_HEARTBEATS.
+   */
+  BENCH_REPORT = 9,
+  /*!
+   * Tilt angles of BENCH_TILT_SAMPLES random samples, Tilt_Compute against atan2f and sqrtf from libm.
+   * Parameter 1 is BENCH_TILT_FIXED, BENCH_TILT_FLOAT or BENCH_TILT_ERROR.
+   */
+  BENCH_TILT = 10,
+  /*!
+   * Time between the interrupts of each FTM0 channel since the last run (Timer_GetJitter), in FTM counts.
+   * Two results are sent for each channel which interrupted:
+   *   parameter 1 is (channel << 4) | BENCH_TIMER_MIN_INTERVAL or BENCH_TIMER_MAX_INTERVAL.
+   * The jitter of a periodic timer, such as the poll timer, is the difference.
+   */
+  BENCH_TIMER = 11,
+  /*!
+   * Cycles from pending the UART interrupt to the return of UART_ISR, the largest of BENCH_RUNS,
+   * with the Flash idle and while a sector of the inactive block is erased.
+   * Parameter 1 is BENCH_UART_FLASH_IDLE or BENCH_UART_FLASH_ERASE, the difference is the stall the erase adds
+   * to the receive path. Fails during a firmware update, as the sector is part of the image.
+   */
+  BENCH_UART_ERASE = 12
+} TBench;
+
+/*!
+ * @brief BENCH_FMC metric: cycles for Packet_Get to parse a whole packet from the receive FIFO.
+ */
+#define BENCH_FMC_PACKET_PARSE 0
+
+/*!
+ * @brief BENCH_FMC metric: cycles to enter and leave FTM0_ISR with no channel pending.
+ */
+#define BENCH_FMC_ISR 1
+
+/*!
+ * @brief BENCH_I2C burst length, a full MMA8451Q FIFO of 32 XYZ samples.
+ */
+#define BENCH_I2C_BYTES 192
+
+/*!
+ * @brief BENCH_I2C metric: I2C and eDMA interrupts taken by one burst.
+ */
+#define BENCH_I2C_INTERRUPTS 0
+
+/*!
+ * @brief BENCH_I2C metric: CPU cycles spent in the interrupts per byte received.
+ */
+#define BENCH_I2C_CYCLES_PER_BYTE 1
+
+/*!
+ * @brief BENCH_ACCEL_SLEEP metric: accelerometer interrupts taken in the state.
+ */
+#define BENCH_SLEEP_INTERRUPTS 0
+
+/*!
+ * @brief BENCH_ACCEL_SLEEP metric: OS ticks spent in the state.
+ */
+#define BENCH_SLEEP_TICKS 1
+
+/*!
+ * @brief BENCH_ACCEL_SLEEP metric: time from the switch into the state to the first sample at its rate, in 100 us.
+ */
+#define BENCH_SLEEP_LATENCY 2
+
+/*!
+ * @brief BENCH_ACCEL_LATENCY metric: shortest latency, in us.
+ */
+#define BENCH_LATENCY_MIN 0
+
+/*!
+ * @brief BENCH_ACCEL_LATENCY metric: mean latency, in us.
+ */
+#define BENCH_LATENCY_MEAN 1
+
+/*!
+ * @brief BENCH_ACCEL_LATENCY metric: longest latency, in us.
+ */
+#define BENCH_LATENCY_MAX 2
+
+/*!
+ * @brief BENCH_MEDIAN windows, the smallest, the middle and the largest.
+ */
+#define BENCH_MEDIAN_WINDOWS { 3, 15, 63 }
+
+/*!
+ * @brief BENCH_MEDIAN values added for each window.
+ */
+#define BENCH_MEDIAN_UPDATES 256
+
+/*!
+ * @brief BENCH_MEDIAN metric: Median_Update.
+ */
+#define BENCH_MEDIAN_STREAMING 0
+
+/*!
+ * @brief BENCH_MEDIAN metric: insertion sort of a copy of the window.
+ */
+#define BENCH_MEDIAN_SORT 1
+
+/*!
+ * @brief BENCH_MEDIAN3 metric: Median_Filter3Int16 on each axis.
+ */
+#define BENCH_MEDIAN3_SCALAR 0
+
+/*!
+ * @brief BENCH_MEDIAN3 metric: Median_Filter3Packed on X and Y, then Z.
+ */
+#define BENCH_MEDIAN3_PACKED 1
+
+/*!
+ * @brief BENCH_FFT sizes.
+ */
+#define BENCH_FFT_SIZES { 256, 1024 }
+
+/*!
+ * @brief BENCH_FFT metric: time for the whole frame, in us.
+ */
+#define BENCH_FFT_MICROSECONDS 0
+
+/*!
+ * @brief BENCH_FFT metric: cycles per sample of the frame.
+ */
+#define BENCH_FFT_CYCLES_PER_SAMPLE 1
+
+/*!
+ * @brief BENCH_REPORT metric: samples checked.
+ */
+#define BENCH_REPORT_SAMPLES 0
+
+/*!
+ * @brief BENCH_REPORT metric: samples sent.
+ */
+#define BENCH_REPORT_SENT 1
+
+/*!
+ * @brief BENCH_REPORT metric: samples sent only for the heartbeat.
+ */
+#define BENCH_REPORT_HEARTBEATS 2
+
+/*!
+ * @brief BENCH_TILT samples.
+ */
+#define BENCH_TILT_SAMPLES 256
+
+/*!
+ * @brief BENCH_TILT metric: cycles per sample of Tilt_Compute.
+ */
+#define BENCH_TILT_FIXED 0
+
+/*!
+ * @brief BENCH_TILT metric: cycles per sample of the same angles in float.
+ */
+#define BENCH_TILT_FLOAT 1
+
+/*!
+ * @brief BENCH_TILT metric: largest difference between the two, in millidegrees.
+ */
+#define BENCH_TILT_ERROR 2
+
+/*!
+ * @brief BENCH_TIMER channels reported.
+ */
+#define BENCH_TIMER_CHANNELS 8
+
+/*!
+ * @brief BENCH_TIMER metric: shortest time between interrupts.
+ */
+#define BENCH_TIMER_MIN_INTERVAL 0
+
+/*!
+ * @brief BENCH_TIMER metric: longest time between interrupts.
+ */
+#define BENCH_TIMER_MAX_INTERVAL 1
+
+/*!
+ * @brief BENCH_UART_ERASE metric: with the Flash idle.
+ */
+#define BENCH_UART_FLASH_IDLE 0
+
+/*!
+ * @brief BENCH_UART_ERASE metric: during the erase.
+ */
+#define BENCH_UART_FLASH_ERASE 1
+
+/*! @brief Starts the DWT cycle counter.
+ *
+ *  @return BOOL - TRUE if the counter is running.
+ */
+BOOL Bench_Init();
+
+/*! @brief Runs a benchmark.
+ *
+ *  Each result is sent as a CMD_TX_BENCHMARK packet,
+ *  parameters 2 and 3 are the cycle count (LSB first, saturated at 0xFFFF).
+ *  @param bench The benchmark to run.
+ *  @return BOOL - TRUE if the benchmark ran.
+ */
+BOOL Bench_Run(const TBench bench);
+
+#endif
+
+/*!
+** @}
+*/
@@ -12,10 +12,15 @@
 #include "cmd.h"
 
 #include "accel.h"
+#include "bench.h"
+#include "dsp.h"
+#include "filter.h"
 #include "flash.h"
 #include "packet.h"
+#include "report.h"
 #include "RTC.h"
 #include "types.h"
+#include "update.h"
 
 /*
  * Tower software version V1.0
@@ -26,6 +31,11 @@ const uint8_t TOWER_VERISON_L = 0;
 static uint16union_t volatile *TowerNumber;
 static uint16union_t volatile *TowerMode;
 
+/*!
+ * @brief Expected CRC of the firmware update.
+ */
+static uint32union_t UpdateCRC;
+
 BOOL CMD_Init()
 {
 	BOOL allocNumber = Flash_AllocateVar((volatile void **) &TowerNumber, sizeof(uint16union_t));
@@ -164,23 +174,551 @@ BOOL CMD_ProtocolMode(const uint8_t getSet, const uint8_t mode, const uint8_t ze
 		{
 			modeInt = 1;
 		}
+		else if (Accel_GetMode() == ACCEL_FIFO)
+		{
+			modeInt = 2;
+		}
+		else if (Accel_GetMode() == ACCEL_EVENT)
+		{
+			modeInt = 3;
+		}
 		return Packet_Put(CMD_TX_TOWER_MODE, 0x01, modeInt, 0x0);
 	}
 	else if (getSet == 2)
 	{
-		if (mode > 1)
+		const TAccelMode modes[] = { ACCEL_POLL, ACCEL_INT, ACCEL_FIFO, ACCEL_EVENT };
+		if (mode >= sizeof(modes) / sizeof(modes[0]))
+		{
+			return bFALSE;
+		}
+		Accel_SetMode(modes[mode]);
+		return bTRUE;
+	}
+	return bFALSE;
+}
+
+/*!
+ * @brief Send a group of 14-bit samples.
+ * @param samples The samples.
+ * @param count The number of samples, 1 to CMD_ACCELEROMETER_PACKED_GROUP.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+static BOOL SendPackedGroup(const TAccelSample * const samples, const uint8_t count)
+{
+	uint8_t command = CMD_TX_ACCELEROMETER_PACKED | (count - 1);
+	uint8_t parameters[3];
+	uint8_t fill = 0;
+	//Never holds more than 7 + 14 bits
+	uint32_t bits = 0;
+	uint8_t nbBits = 0;
+
+	for (uint8_t i = 0; i < count; i++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			bits = (bits << 14) | ((uint16_t) samples[i].axes[axis] & 0x3FFF);
+			nbBits += 14;
+			while (nbBits >= 8)
+			{
+				nbBits -= 8;
+				parameters[fill++] = (uint8_t) (bits >> nbBits);
+				if (fill == sizeof(parameters))
+				{
+					if (!Packet_Put(command, parameters[0], parameters[1], parameters[2]))
+					{
+						return bFALSE;
+					}
+					command = CMD_TX_ACCELEROMETER_PACKED_MORE;
+					fill = 0;
+				}
+			}
+		}
+	}
+
+	if (nbBits)
+	{
+		parameters[fill++] = (uint8_t) (bits << (8 - nbBits));
+	}
+	if (fill)
+	{
+		while (fill < sizeof(parameters))
+		{
+			parameters[fill++] = 0;
+		}
+		return Packet_Put(command, parameters[0], parameters[1], parameters[2]);
+	}
+	return bTRUE;
+}
+
+BOOL CMD_SendAccelerometerValues(const TAccelSample * const samples, const uint8_t count)
+{
+	if (Accel_GetResolution() == ACCEL_RESOLUTION_8_BIT)
+	{
+		for (uint8_t i = 0; i < count; i++)
+		{
+			//Back to the MSB registers
+			if (!Packet_Put(CMD_TX_ACCELEROMETER_VALUES,
+					(uint8_t) (samples[i].axes[ACCEL_X] >> 6),
+					(uint8_t) (samples[i].axes[ACCEL_Y] >> 6),
+					(uint8_t) (samples[i].axes[ACCEL_Z] >> 6)))
+			{
+				return bFALSE;
+			}
+		}
+		return bTRUE;
+	}
+
+	for (uint8_t first = 0; first < count; first += CMD_ACCELEROMETER_PACKED_GROUP)
+	{
+		uint8_t group = count - first;
+		if (group > CMD_ACCELEROMETER_PACKED_GROUP)
+		{
+			group = CMD_ACCELEROMETER_PACKED_GROUP;
+		}
+		if (!SendPackedGroup(&samples[first], group))
+		{
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+BOOL CMD_AccelResolution(const uint8_t getSet, const uint8_t bits, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (bits)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_RESOLUTION, 0x01,
+				(Accel_GetResolution() == ACCEL_RESOLUTION_14_BIT) ? 14 : 8, 0x0);
+	}
+	else if (getSet == 2)
+	{
+		if (bits == 8)
+		{
+			return Accel_SetResolution(ACCEL_RESOLUTION_8_BIT);
+		}
+		if (bits == 14)
+		{
+			return Accel_SetResolution(ACCEL_RESOLUTION_14_BIT);
+		}
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelDataRate(const uint8_t getSet, const uint8_t rate, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (rate)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_DATA_RATE, 0x01, (uint8_t) Accel_GetDataRate(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Accel_SetDataRate((TAccelDataRate) rate);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelRange(const uint8_t getSet, const uint8_t range, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (range)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_RANGE, 0x01, (uint8_t) Accel_GetRange(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Accel_SetRange((TAccelRange) range);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelOversampling(const uint8_t getSet, const uint8_t oversampling, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (oversampling)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_OVERSAMPLING, 0x01, (uint8_t) Accel_GetOversampling(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Accel_SetOversampling((TAccelOversampling) oversampling);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelEvents(const uint8_t getSet, const uint8_t engines, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (engines)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_EVENTS, 0x01, Accel_GetEvents(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Accel_SetEvents(engines);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelAutoSleep(const uint8_t getSet, const uint8_t enable, const uint8_t zero)
+{
+	if (zero || (enable > 1))
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (enable)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_AUTO_SLEEP, 0x01, Accel_GetAutoSleep() ? 1 : 0, (uint8_t) Accel_GetPowerState());
+	}
+	else if (getSet == 2)
+	{
+		Accel_SetAutoSleep(enable ? bTRUE : bFALSE);
+		return bTRUE;
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelAcquisition(const uint8_t getSet, const uint8_t acquisition, const uint8_t zero)
+{
+	if (zero || (acquisition > ACCEL_ACQUISITION_DIRECT))
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (acquisition)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_ACQUISITION, 0x01, (uint8_t) Accel_GetAcquisition(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		Accel_SetAcquisition((TAccelAcquisition) acquisition);
+		return bTRUE;
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelMedianWindow(const uint8_t getSet, const uint8_t window, const uint8_t zero)
+{
+	if (zero)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (window)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_MEDIAN_WINDOW, 0x01, Filter_GetMedianWindow(), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Filter_SetMedianWindow(window);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelPipeline(const uint8_t getSet, const uint8_t index, const uint8_t stage)
+{
+	if (index >= DSP_STAGES_MAX)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (stage)
 		{
 			return bFALSE;
 		}
-		Accel_SetMode(mode ? ACCEL_INT : ACCEL_POLL);
+		return Packet_Put(CMD_TX_ACCEL_PIPELINE, index, (uint8_t) Dsp_GetStage(index), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Dsp_SetStage(index, (TDspStage) stage);
+	}
+	return bFALSE;
+}
+
+/*!
+ * @brief log2 of a power of 2.
+ * @param value The value.
+ * @return The exponent.
+ */
+static uint8_t Log2(uint16_t value)
+{
+	uint8_t exponent = 0;
+	while (value >>= 1)
+	{
+		exponent++;
+	}
+	return exponent;
+}
+
+BOOL CMD_AccelSpectrum(const uint8_t getSet, const uint8_t sizeLog2, const uint8_t axis)
+{
+	if (getSet == 1)
+	{
+		if (sizeLog2 || axis)
+		{
+			return bFALSE;
+		}
+		uint16_t size = Spectrum_GetSize();
+		return Packet_Put(CMD_TX_ACCEL_SPECTRUM, 0x01, size ? Log2(size) : 0, Spectrum_GetAxis());
+	}
+	else if (getSet == 2)
+	{
+		if (sizeLog2 > 15)
+		{
+			return bFALSE;
+		}
+		return Spectrum_Set(sizeLog2 ? (uint16_t) (1 << sizeLog2) : 0, axis);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_SendSpectrumPeaks(const TSpectrumPeaks * const peaks)
+{
+	if (!Packet_Put(CMD_TX_ACCEL_SPECTRUM_FRAME, peaks->axis, Log2(peaks->size), peaks->count))
+	{
+		return bFALSE;
+	}
+	for (uint8_t i = 0; i < peaks->count; i++)
+	{
+		uint16union_t magnitude;
+		magnitude.l = peaks->peaks[i].magnitude;
+		if (!Packet_Put(CMD_TX_ACCEL_PEAK | ((peaks->peaks[i].bin >> 8) & 0x01), (uint8_t) peaks->peaks[i].bin, magnitude.s.Lo,
+				magnitude.s.Hi))
+		{
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+BOOL CMD_AccelSummaryWindow(const uint8_t getSet, const uint8_t lsb, const uint8_t msb)
+{
+	if (getSet == 1)
+	{
+		if (lsb || msb)
+		{
+			return bFALSE;
+		}
+		uint16union_t window;
+		window.l = Summary_GetWindow();
+		return Packet_Put(CMD_TX_ACCEL_SUMMARY_WINDOW, 0x01, window.s.Lo, window.s.Hi);
+	}
+	else if (getSet == 2)
+	{
+		uint16union_t window;
+		window.s.Lo = lsb;
+		window.s.Hi = msb;
+		return Summary_SetWindow(window.l);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_SendSummary(const TSummary * const summary)
+{
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		for (uint8_t statistic = 0; statistic < SUMMARY_STATISTICS; statistic++)
+		{
+			uint16union_t value;
+			value.l = summary->values[axis][statistic];
+			if (!Packet_Put(CMD_TX_ACCEL_SUMMARY | statistic, axis, value.s.Lo, value.s.Hi))
+			{
+				return bFALSE;
+			}
+		}
+	}
+	return bTRUE;
+}
+
+BOOL CMD_AccelDeadband(const uint8_t getSet, const uint8_t axis, const uint8_t deadband)
+{
+	if (axis > ACCEL_Z)
+	{
+		return bFALSE;
+	}
+	if (getSet == 1)
+	{
+		if (deadband)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_DEADBAND, axis, Report_GetDeadband(axis), 0x0);
+	}
+	else if (getSet == 2)
+	{
+		return Report_SetDeadband(axis, deadband);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_AccelHeartbeat(const uint8_t getSet, const uint8_t lsb, const uint8_t msb)
+{
+	if (getSet == 1)
+	{
+		if (lsb || msb)
+		{
+			return bFALSE;
+		}
+		uint16union_t interval;
+		interval.l = Report_GetHeartbeat();
+		return Packet_Put(CMD_TX_ACCEL_HEARTBEAT, 0x01, interval.s.Lo, interval.s.Hi);
+	}
+	else if (getSet == 2)
+	{
+		uint16union_t interval;
+		interval.s.Lo = lsb;
+		interval.s.Hi = msb;
+		Report_SetHeartbeat(interval.l);
 		return bTRUE;
 	}
 	return bFALSE;
 }
 
-BOOL CMD_SendAccelerometerValues(const uint8_t values[3])
+BOOL CMD_AccelTilt(const uint8_t getSet, const uint8_t on, const uint8_t smoothing)
+{
+	if (getSet == 1)
+	{
+		if (on || smoothing)
+		{
+			return bFALSE;
+		}
+		return Packet_Put(CMD_TX_ACCEL_TILT, 0x01, Tilt_IsOn() ? 1 : 0, Tilt_GetSmoothing());
+	}
+	else if (getSet == 2)
+	{
+		if (on > 1)
+		{
+			return bFALSE;
+		}
+		return Tilt_Set(on ? bTRUE : bFALSE, smoothing);
+	}
+	return bFALSE;
+}
+
+BOOL CMD_SendTilt(const TTilt * const tilt)
+{
+	//Top 12 bits of each angle
+	uint16_t roll = ((uint16_t) tilt->roll) >> 4;
+	uint16_t pitch = ((uint16_t) tilt->pitch) >> 4;
+	return Packet_Put(CMD_TX_ACCEL_ANGLES, (uint8_t) roll, (uint8_t) ((roll >> 8) | (pitch << 4)), (uint8_t) (pitch >> 4));
+}
+
+BOOL CMD_SendAccelerometerEvents(const TAccelEvents * const events)
+{
+	uint32_8union_t time;
+	time.l = events->time;
+	if (!Packet_Put(CMD_TX_ACCEL_EVENT_TIME, time.s.d, time.s.c, time.s.b))
+	{
+		return bFALSE;
+	}
+	for (uint8_t i = 0; i < events->count; i++)
+	{
+		if (!Packet_Put(CMD_TX_ACCEL_EVENT, events->events[i].engine, events->events[i].source, 0x0))
+		{
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+BOOL CMD_UpdateBegin(const uint8_t lsb, const uint8_t mid, const uint8_t msb)
+{
+	uint32_8union_t size;
+	size.s.d = lsb;
+	size.s.c = mid;
+	size.s.b = msb;
+	size.s.a = 0;
+	return Update_Begin(size.l);
+}
+
+BOOL CMD_UpdateData(const uint8_t b0, const uint8_t b1, const uint8_t b2)
+{
+	const uint8_t data[3] = { b0, b1, b2 };
+	return Update_Write(data, sizeof(data));
+}
+
+BOOL CMD_UpdateCRC(const uint8_t half, const uint8_t lsb, const uint8_t msb)
+{
+	uint16union_t temp;
+	temp.s.Lo = lsb;
+	temp.s.Hi = msb;
+	if (half == 0)
+	{
+		UpdateCRC.s.Lo = temp.l;
+	}
+	else if (half == 1)
+	{
+		UpdateCRC.s.Hi = temp.l;
+	}
+	else
+	{
+		return bFALSE;
+	}
+	return bTRUE;
+}
+
+BOOL CMD_UpdateCommit()
+{
+	return Update_Commit(UpdateCRC.l);
+}
+
+BOOL CMD_Benchmark(const uint8_t bench)
+{
+	return Bench_Run((TBench) bench);
+}
+
+BOOL CMD_SendBenchmark(const uint8_t id, const uint16_t cycles)
 {
-	return Packet_Put(CMD_TX_ACCELEROMETER_VALUES, values[0], values[1], values[2]);
+	uint16union_t temp;
+	temp.l = cycles;
+	return Packet_Put(CMD_TX_BENCHMARK, id, temp.s.Lo, temp.s.Hi);
 }
 
 /*!
@@ -14,6 +14,11 @@
 
 #include "types.h"
 
+#include "accel.h"
+#include "summary.h"
+#include "spectrum.h"
+#include "tilt.h"
+
 /*****************************************
  * Packets Transmitted from Tower to PC
  */
@@ -57,10 +62,161 @@
 #define CMD_TX_TOWER_MODE 0x0d
 
 /*!
- * Send the accelerometer values to the PC.
+ * Send the accelerometer values to the PC, the 8-bit MSBs of X, Y and Z.
  */
 #define CMD_TX_ACCELEROMETER_VALUES 0x10
 
+/*
+ * Replies to a get use the code of the RX packet which asked, as CMD_TX_PROTOCOL_MODE,
+ * CMD_TX_TOWER_NUMBER and CMD_TX_TOWER_MODE do.
+ */
+
+/*!
+ * Send the accelerometer resolution, parameter 2 is the bits per axis (8 or 14).
+ */
+#define CMD_TX_ACCEL_RESOLUTION 0x11
+
+/*!
+ * Send the accelerometer output data rate, parameter 2 is the TAccelDataRate.
+ */
+#define CMD_TX_ACCEL_DATA_RATE 0x12
+
+/*!
+ * Send the accelerometer full-scale range, parameter 2 is the TAccelRange.
+ */
+#define CMD_TX_ACCEL_RANGE 0x13
+
+/*!
+ * Send the accelerometer oversampling mode, parameter 2 is the TAccelOversampling.
+ */
+#define CMD_TX_ACCEL_OVERSAMPLING 0x14
+
+/*!
+ * Send the engines used in event mode, parameter 2 is the ACCEL_EVENT_* mask.
+ */
+#define CMD_TX_ACCEL_EVENTS 0x15
+
+/*!
+ * Send whether accelerometer auto-sleep is on, parameter 2 is 1 if on,
+ * parameter 3 is the power state (0 asleep, 1 awake).
+ */
+#define CMD_TX_ACCEL_AUTO_SLEEP 0x16
+
+/*!
+ * Send how accelerometer reads are started, parameter 2 is the TAccelAcquisition.
+ */
+#define CMD_TX_ACCEL_ACQUISITION 0x17
+
+/*!
+ * Send the median filter window of poll mode, parameter 2 is the number of samples.
+ */
+#define CMD_TX_ACCEL_MEDIAN_WINDOW 0x18
+
+/*!
+ * Send a stage of the filter pipeline, parameter 1 is the stage index, parameter 2 the TDspStage.
+ */
+#define CMD_TX_ACCEL_PIPELINE 0x19
+
+/*!
+ * Send the spectrum analysis settings, parameter 2 is log2 of the frame size (0 when off), parameter 3 the axis.
+ */
+#define CMD_TX_ACCEL_SPECTRUM 0x1A
+
+/*!
+ * Send the summary window length, parameters 2 and 3 are the samples in a window (LSB first, 0 when off).
+ */
+#define CMD_TX_ACCEL_SUMMARY_WINDOW 0x1B
+
+/*!
+ * Send the dead-band of an axis, parameter 1 is the axis, parameter 2 the dead-band in 14-bit counts.
+ */
+#define CMD_TX_ACCEL_DEADBAND 0x1C
+
+/*!
+ * Send the heartbeat interval, parameters 2 and 3 are the time in ms (LSB first, 0 when off).
+ */
+#define CMD_TX_ACCEL_HEARTBEAT 0x1D
+
+/*!
+ * Send the tilt angle settings, parameter 2 is 1 when angles are sent in place of the samples, parameter 3 the smoothing shift.
+ */
+#define CMD_TX_ACCEL_TILT 0x1E
+
+/*
+ * Streamed packets, sent without being asked. None of their codes is used by an RX packet.
+ * Some carry data in the low bits of the code:
+ *
+ *   Code        Packet                            Low bits of the code
+ *   0x60        CMD_TX_ACCEL_EVENT_TIME           -
+ *   0x61        CMD_TX_ACCEL_EVENT                -
+ *   0x62        CMD_TX_ACCEL_SPECTRUM_FRAME       -
+ *   0x63        CMD_TX_ACCEL_ANGLES               -
+ *   0x64-0x65   CMD_TX_ACCEL_PEAK                 bit 0: bit 8 of the bin
+ *   0x68-0x6B   CMD_TX_ACCELEROMETER_PACKED       bits 0..1: samples in the group - 1
+ *   0x6C        CMD_TX_ACCELEROMETER_PACKED_MORE  -
+ *   0x70-0x75   CMD_TX_ACCEL_SUMMARY              bits 0..2: the TSummaryStatistic
+ */
+
+/*!
+ * Starts the events of one accelerometer interrupt, parameters are bits 0..23 of the OS tick count (LSB first).
+ */
+#define CMD_TX_ACCEL_EVENT_TIME 0x60
+
+/*!
+ * An accelerometer event, parameter 1 is the ACCEL_EVENT_* engine, parameter 2 its source register.
+ */
+#define CMD_TX_ACCEL_EVENT 0x61
+
+/*!
+ * Starts the peaks of one spectrum frame, parameter 1 is the axis,
+ * parameter 2 log2 of the frame size, parameter 3 the number of CMD_TX_ACCEL_PEAK packets which follow.
+ */
+#define CMD_TX_ACCEL_SPECTRUM_FRAME 0x62
+
+/*!
+ * The tilt of one sample, as 12-bit two's complement binary angles (4096 to a turn).
+ * Parameter 1 is bits 0..7 of the roll, parameter 2 bits 8..11 of the roll
+ * in its low nibble and bits 0..3 of the pitch in its high nibble, parameter 3 bits 4..11 of the pitch.
+ */
+#define CMD_TX_ACCEL_ANGLES 0x63
+
+/*!
+ * A spectrum peak, ORed with bit 8 of the bin. Parameter 1 is bits 0..7 of the bin,
+ * parameters 2 and 3 the magnitude (LSB first). The frequency is bin / frame size of the sample rate.
+ */
+#define CMD_TX_ACCEL_PEAK 0x64
+
+/*!
+ * First packet of a group of 14-bit accelerometer samples, ORed with (samples - 1).
+ * The 14-bit two's complement axes (X0, Y0, Z0, X1...) are packed MSB first
+ * into the parameters of this packet and of the CMD_TX_ACCELEROMETER_PACKED_MORE
+ * packets which follow, the last packet is padded with 0 bits.
+ * A group of 1 to 4 samples takes 2, 4, 6 or 7 packets.
+ */
+#define CMD_TX_ACCELEROMETER_PACKED 0x68
+
+/*!
+ * Continues a CMD_TX_ACCELEROMETER_PACKED group.
+ */
+#define CMD_TX_ACCELEROMETER_PACKED_MORE 0x6C
+
+/*!
+ * Most samples in a CMD_TX_ACCELEROMETER_PACKED group.
+ */
+#define CMD_ACCELEROMETER_PACKED_GROUP 4
+
+/*!
+ * One statistic of a window summary, ORed with the TSummaryStatistic. Parameter 1 is the axis,
+ * parameters 2 and 3 the value (LSB first), the min, max and mean are signed.
+ * Each window sends SUMMARY_STATISTICS packets for X, then Y, then Z.
+ */
+#define CMD_TX_ACCEL_SUMMARY 0x70
+
+/*!
+ * A benchmark result, parameter 1 identifies the measurement, parameters 2 and 3 are the cycles.
+ */
+#define CMD_TX_BENCHMARK 0x30
+
 /*****************************************
  * Packets Transmitted from PC to Tower
  */
@@ -88,7 +244,7 @@
 #define CMD_RX_SPECIAL_GET_VERSION 0x09
 
 /*!
- * Get / Set the protocol mode.
+ * Get / Set the protocol mode (0 polled, 1 data ready interrupt, 2 FIFO watermark, 3 events).
  */
 #define CMD_RX_PROTOCOL_MODE 0x0a
 
@@ -108,6 +264,110 @@
  */
 #define CMD_RX_TOWER_MODE 0x0d
 
+/*!
+ * Get / Set the accelerometer resolution, parameter 2 is the bits per axis (8 or 14).
+ */
+#define CMD_RX_ACCEL_RESOLUTION 0x11
+
+/*!
+ * Get / Set the accelerometer output data rate, parameter 2 is the TAccelDataRate (0 800 Hz ... 7 1.56 Hz).
+ */
+#define CMD_RX_ACCEL_DATA_RATE 0x12
+
+/*!
+ * Get / Set the accelerometer full-scale range, parameter 2 is the TAccelRange (0 2g, 1 4g, 2 8g).
+ */
+#define CMD_RX_ACCEL_RANGE 0x13
+
+/*!
+ * Get / Set the accelerometer oversampling mode, parameter 2 is the TAccelOversampling
+ * (0 normal, 1 low noise low power, 2 high resolution, 3 low power).
+ */
+#define CMD_RX_ACCEL_OVERSAMPLING 0x14
+
+/*!
+ * Get / Set the engines used in event mode, parameter 2 is the ACCEL_EVENT_* mask.
+ */
+#define CMD_RX_ACCEL_EVENTS 0x15
+
+/*!
+ * Get / Set accelerometer auto-sleep, parameter 2 is 1 to turn it on, 0 to turn it off.
+ */
+#define CMD_RX_ACCEL_AUTO_SLEEP 0x16
+
+/*!
+ * Get / Set how accelerometer reads are started, parameter 2 is the TAccelAcquisition
+ * (0 from the main thread, 1 directly from the data ready interrupt).
+ */
+#define CMD_RX_ACCEL_ACQUISITION 0x17
+
+/*!
+ * Get / Set the median filter window of poll mode, parameter 2 is the number of samples (3 to 63).
+ */
+#define CMD_RX_ACCEL_MEDIAN_WINDOW 0x18
+
+/*!
+ * Get / Set a stage of the filter pipeline run in interrupt and FIFO modes,
+ * parameter 2 is the stage index (0 runs first), parameter 3 the TDspStage.
+ */
+#define CMD_RX_ACCEL_PIPELINE 0x19
+
+/*!
+ * Get / Set the spectrum analysis of interrupt and FIFO modes, sent in place of the samples.
+ * Parameter 2 is log2 of the frame size (4 to 10) or 0 to turn it off, parameter 3 the axis (0 X, 1 Y, 2 Z).
+ */
+#define CMD_RX_ACCEL_SPECTRUM 0x1A
+
+/*!
+ * Get / Set the window summaries of interrupt and FIFO modes, sent in place of the samples.
+ * Parameters 2 and 3 are the samples in a window (LSB first), 0 turns them off.
+ */
+#define CMD_RX_ACCEL_SUMMARY_WINDOW 0x1B
+
+/*!
+ * Get / Set the dead-band of an axis in poll mode, parameter 2 is the axis (0 X, 1 Y, 2 Z),
+ * parameter 3 the change in 14-bit counts needed to send a sample.
+ */
+#define CMD_RX_ACCEL_DEADBAND 0x1C
+
+/*!
+ * Get / Set the longest time without a sample in poll mode, parameters 2 and 3 are the time in ms (LSB first), 0 turns it off.
+ */
+#define CMD_RX_ACCEL_HEARTBEAT 0x1D
+
+/*!
+ * Get / Set the tilt angles of interrupt and FIFO modes, sent in place of the samples.
+ * Parameter 2 is 1 to turn them on or 0 to turn them off, parameter 3 the smoothing shift (0 to 8).
+ */
+#define CMD_RX_ACCEL_TILT 0x1E
+
+/*!
+ * Start a firmware update, parameters are the 24-bit image size (LSB first).
+ * The image is erased before the packet is handled, so send it with the acknowledgement bit
+ * and wait for the acknowledgement (seconds for a large image) before the first CMD_RX_UPDATE_DATA.
+ */
+#define CMD_RX_UPDATE_BEGIN 0x50
+
+/*!
+ * The next 3 bytes of the firmware image.
+ */
+#define CMD_RX_UPDATE_DATA 0x51
+
+/*!
+ * Half of the expected CRC-32, parameter 1 selects the low (0) or high (1) half.
+ */
+#define CMD_RX_UPDATE_CRC 0x52
+
+/*!
+ * Verify the image and swap to it on reset.
+ */
+#define CMD_RX_UPDATE_COMMIT 0x53
+
+/*!
+ * Run a benchmark, parameter 1 is the benchmark (TBench).
+ */
+#define CMD_RX_BENCHMARK 0x30
+
 /*!
  * Packet parameter 1 to get tower number.
  */
@@ -216,9 +476,221 @@ BOOL CMD_SetTime(const uint8_t hours, const uint8_t minutes, const uint8_t secon
 BOOL CMD_ProtocolMode(const uint8_t getSet, const uint8_t mode, const uint8_t zero);
 
 /*!
+ * @brief Send accelerometer samples in the current resolution.
  *
+ * 8-bit samples are sent one CMD_TX_ACCELEROMETER_VALUES packet each,
+ * 14-bit samples in CMD_TX_ACCELEROMETER_PACKED groups of up to CMD_ACCELEROMETER_PACKED_GROUP.
+ * @param samples The samples, oldest first.
+ * @param count The number of samples.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_SendAccelerometerValues(const TAccelSample * const samples, const uint8_t count);
+
+/*!
+ * @brief Get or set the accelerometer resolution.
+ * @param getSet 1 to get, 2 to set.
+ * @param bits The bits per axis when setting (8 or 14), 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelResolution(const uint8_t getSet, const uint8_t bits, const uint8_t zero);
+
+/*!
+ * @brief Get or set the accelerometer output data rate.
+ * @param getSet 1 to get, 2 to set.
+ * @param rate The TAccelDataRate when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelDataRate(const uint8_t getSet, const uint8_t rate, const uint8_t zero);
+
+/*!
+ * @brief Get or set the accelerometer full-scale range.
+ * @param getSet 1 to get, 2 to set.
+ * @param range The TAccelRange when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelRange(const uint8_t getSet, const uint8_t range, const uint8_t zero);
+
+/*!
+ * @brief Get or set the accelerometer oversampling mode.
+ * @param getSet 1 to get, 2 to set.
+ * @param oversampling The TAccelOversampling when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelOversampling(const uint8_t getSet, const uint8_t oversampling, const uint8_t zero);
+
+/*!
+ * @brief Get or set the engines used in event mode.
+ * @param getSet 1 to get, 2 to set.
+ * @param engines The ACCEL_EVENT_* mask when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelEvents(const uint8_t getSet, const uint8_t engines, const uint8_t zero);
+
+/*!
+ * @brief Get or set accelerometer auto-sleep.
+ * @param getSet 1 to get, 2 to set.
+ * @param enable 1 to turn auto-sleep on when setting, 0 otherwise.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelAutoSleep(const uint8_t getSet, const uint8_t enable, const uint8_t zero);
+
+/*!
+ * @brief Get or set how accelerometer reads are started.
+ * @param getSet 1 to get, 2 to set.
+ * @param acquisition The TAccelAcquisition when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelAcquisition(const uint8_t getSet, const uint8_t acquisition, const uint8_t zero);
+
+/*!
+ * @brief Get or set the median filter window of poll mode.
+ * @param getSet 1 to get, 2 to set.
+ * @param window The number of samples when setting, 0 when getting.
+ * @param zero Must be 0.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelMedianWindow(const uint8_t getSet, const uint8_t window, const uint8_t zero);
+
+/*!
+ * @brief Get or set a stage of the filter pipeline.
+ * @param getSet 1 to get, 2 to set.
+ * @param index The stage index.
+ * @param stage The TDspStage when setting, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelPipeline(const uint8_t getSet, const uint8_t index, const uint8_t stage);
+
+/*!
+ * @brief Get or set the spectrum analysis.
+ * @param getSet 1 to get, 2 to set.
+ * @param sizeLog2 log2 of the frame size, or 0 to turn it off, 0 when getting.
+ * @param axis The axis when setting, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelSpectrum(const uint8_t getSet, const uint8_t sizeLog2, const uint8_t axis);
+
+/*!
+ * @brief Send the peaks of one spectrum frame.
+ *
+ * A CMD_TX_ACCEL_SPECTRUM_FRAME packet is followed by a CMD_TX_ACCEL_PEAK packet for each peak.
+ * @param peaks The peaks.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_SendSpectrumPeaks(const TSpectrumPeaks * const peaks);
+
+/*!
+ * @brief Get or set the window summaries.
+ * @param getSet 1 to get, 2 to set.
+ * @param lsb Bits 0..7 of the window length, 0 when getting.
+ * @param msb Bits 8..15 of the window length, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelSummaryWindow(const uint8_t getSet, const uint8_t lsb, const uint8_t msb);
+
+/*!
+ * @brief Send the summary of one window, a CMD_TX_ACCEL_SUMMARY packet for each statistic of each axis.
+ * @param summary The summary.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_SendSummary(const TSummary * const summary);
+
+/*!
+ * @brief Get or set the dead-band of an axis.
+ * @param getSet 1 to get, 2 to set.
+ * @param axis The axis.
+ * @param deadband The dead-band when setting, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelDeadband(const uint8_t getSet, const uint8_t axis, const uint8_t deadband);
+
+/*!
+ * @brief Get or set the heartbeat interval.
+ * @param getSet 1 to get, 2 to set.
+ * @param lsb Bits 0..7 of the interval, 0 when getting.
+ * @param msb Bits 8..15 of the interval, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelHeartbeat(const uint8_t getSet, const uint8_t lsb, const uint8_t msb);
+
+/*!
+ * @brief Get or set the tilt angles.
+ * @param getSet 1 to get, 2 to set.
+ * @param on 1 to send angles in place of the samples, 0 when getting.
+ * @param smoothing The smoothing shift when setting, 0 when getting.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_AccelTilt(const uint8_t getSet, const uint8_t on, const uint8_t smoothing);
+
+/*!
+ * @brief Send the tilt of one sample.
+ * @param tilt The angles.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_SendTilt(const TTilt * const tilt);
+
+/*!
+ * @brief Send the events of one accelerometer interrupt.
+ *
+ * A CMD_TX_ACCEL_EVENT_TIME packet is followed by a CMD_TX_ACCEL_EVENT packet for each event.
+ * @param events The events.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_SendAccelerometerEvents(const TAccelEvents * const events);
+
+/*!
+ * @brief Start receiving a firmware update.
+ * @param lsb Bits 0..7 of the image size.
+ * @param mid Bits 8..15 of the image size.
+ * @param msb Bits 16..23 of the image size.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_UpdateBegin(const uint8_t lsb, const uint8_t mid, const uint8_t msb);
+
+/*!
+ * @brief Append 3 bytes to the firmware update.
+ * @param b0 The first byte.
+ * @param b1 The second byte.
+ * @param b2 The third byte.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_UpdateData(const uint8_t b0, const uint8_t b1, const uint8_t b2);
+
+/*!
+ * @brief Set half of the expected CRC of the firmware update.
+ * @param half 0 for the low half, 1 for the high half.
+ * @param lsb The least significant byte of the half.
+ * @param msb The most significant byte of the half.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_UpdateCRC(const uint8_t half, const uint8_t lsb, const uint8_t msb);
+
+/*!
+ * @brief Verify the firmware update and swap to it on the next reset.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_UpdateCommit();
+
+/*!
+ * @brief Run a benchmark.
+ * @param bench The benchmark to run.
+ * @return BOOL TRUE if the operation succeeded.
+ */
+BOOL CMD_Benchmark(const uint8_t bench);
+
+/*!
+ * @brief Send a benchmark result.
+ * @param id Identifies the measurement.
+ * @param cycles The cycle count.
+ * @return BOOL TRUE if the operation succeeded.
  */
-BOOL CMD_SendAccelerometerValues(const uint8_t values[3]);
+BOOL CMD_SendBenchmark(const uint8_t id, const uint16_t cycles);
 
 /*!
 ** @}
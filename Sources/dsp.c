@@ -0,0 +1,401 @@
+/*! @file
+ *
+ *  @brief Implementation of the fixed-point filter pipeline.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-14
+ */
+/*!
+**  @addtogroup dsp_module DSP module documentation
+**  @{
+*/
+#include "dsp.h"
+
+#if defined(__arm__)
+#include "bench.h"
+
+#include "Cpu.h"
+#else
+//The host test, nothing to time and nothing to interrupt
+#define BENCH_CYCLES() 0
+#define EnterCritical()
+#define ExitCritical()
+#endif
+
+/*!
+ * @brief Taps of the FIR stages, an even number so they can be taken in pairs.
+ */
+#define FIR_TAPS 16
+
+/*!
+ * @brief Taps of DSP_STAGE_FIR_LOWPASS in Q15, oldest sample first.
+ *        The filter is symmetric, the leading 0 pads it to FIR_TAPS.
+ */
+static const int16_t LowpassTaps[FIR_TAPS] __attribute__ ((aligned (4))) = {
+		0, -84, -219, -374, 0, 1582, 4321, 7054, 8208, 7054, 4321, 1582, 0, -374, -219, -84 };
+
+/*!
+ * @brief Biquad coefficients in Q30, y = b0 x0 + b1 x1 + b2 x2 + a1 y1 + a2 y2.
+ *        The feedback coefficients are negated, so every term is an add.
+ */
+typedef struct
+{
+  int32_t b0, b1, b2, a1, a2;
+} TBiquadCoefficients;
+
+/*!
+ * @brief Coefficients of DSP_STAGE_BIQUAD_LOWPASS.
+ */
+static const TBiquadCoefficients LowpassBiquad = { 21564350, 43128699, 21564350, 1676130396, -688645970 };
+
+/*!
+ * @brief Coefficients of DSP_STAGE_BIQUAD_HIGHPASS.
+ */
+static const TBiquadCoefficients HighpassBiquad = { 1027080468, -2054160935, 1027080468, 2052132225, -982447822 };
+
+/*!
+ * @brief Fraction bits of the biquad state, 16-bit samples shifted up leaving 2 bits of headroom.
+ */
+#define BIQUAD_STATE_SHIFT 14
+
+/*!
+ * @brief State of a stage, for each axis.
+ */
+typedef struct
+{
+  TDspStage stage;                            /*!< What the stage does. */
+  union
+  {
+    int16_t history[3][FIR_TAPS - 1];         /*!< FIR: the last inputs, oldest first. */
+    struct
+    {
+      int32_t x1, x2, y1, y2;                 /*!< Biquad: the last inputs and outputs, shifted by BIQUAD_STATE_SHIFT. */
+    } biquad[3];
+    uint8_t phase;                            /*!< Decimator: samples until the next one kept. */
+  } state;
+} TStageState;
+
+/*!
+ * @brief The stages as set by Dsp_SetStage.
+ */
+static volatile TDspStage Stages[DSP_STAGES_MAX];
+
+/*!
+ * @brief Asserted when the stages have been set and the state needs clearing.
+ */
+static volatile BOOL StagesChanged;
+
+/*!
+ * @brief The stages being run, only touched by Dsp_Process.
+ */
+static TStageState States[DSP_STAGES_MAX];
+
+/*!
+ * @brief Time spent in each stage, for Dsp_GetStatistics.
+ */
+static TDspStatistics Statistics;
+
+/*!
+ * @brief Two blocks of each axis, the stages read one and write the other.
+ *        FIR stages put their history in front of the block they read.
+ */
+static int16_t Lines[2][3][(FIR_TAPS - 1) + DSP_BLOCK_MAX] __attribute__ ((aligned (4)));
+
+/*!
+ * @brief Two halfwords which might not be word aligned, loaded as one word.
+ */
+typedef struct
+{
+  uint32_t pair;
+} __attribute__ ((packed, aligned (2))) THalfwordPair;
+
+/*!
+ * @brief Multiply the two halfword pairs and add both products to the accumulator.
+ * @param x The first pair.
+ * @param y The second pair.
+ * @param accumulator The accumulator.
+ * @return The new accumulator.
+ */
+static inline int32_t Smlad(const uint32_t x, const uint32_t y, const int32_t accumulator)
+{
+#if defined(__arm__)
+	int32_t result;
+	__asm ("SMLAD %0, %1, %2, %3" : "=r" (result) : "r" (x), "r" (y), "r" (accumulator));
+	return result;
+#else
+	return accumulator + (int16_t) x * (int16_t) y + (int16_t) (x >> 16) * (int16_t) (y >> 16);
+#endif
+}
+
+/*!
+ * @brief Round and saturate a value into a sample.
+ * @param value The value, with shift fraction bits.
+ * @param shift The number of fraction bits.
+ * @return The sample.
+ */
+static inline int16_t Saturate(const int32_t value, const uint8_t shift)
+{
+	int32_t result = (value + (1L << (shift - 1))) >> shift;
+	if (result > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	return (result < INT16_MIN) ? INT16_MIN : (int16_t) result;
+}
+
+/*!
+ * @brief Clear the state of every stage and take up the new stages.
+ */
+static void ClearStages()
+{
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		TStageState * const state = &States[i];
+		state->stage = Stages[i];
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			for (uint8_t tap = 0; tap < FIR_TAPS - 1; tap++)
+			{
+				state->state.history[axis][tap] = 0;
+			}
+		}
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			state->state.biquad[axis].x1 = 0;
+			state->state.biquad[axis].x2 = 0;
+			state->state.biquad[axis].y1 = 0;
+			state->state.biquad[axis].y2 = 0;
+		}
+		state->state.phase = 0;
+	}
+}
+
+/*!
+ * @brief Run the FIR over a block of one axis.
+ * @param taps The taps, oldest sample first.
+ * @param history The last FIR_TAPS - 1 inputs, updated.
+ * @param input The block, with FIR_TAPS - 1 free entries in front of it.
+ * @param count The number of samples in the block.
+ * @param output The filtered block.
+ */
+static void Fir(const int16_t * const taps, int16_t * const history, int16_t * const input, const uint16_t count, int16_t * const output)
+{
+	int16_t * const line = input - (FIR_TAPS - 1);
+	for (uint8_t i = 0; i < FIR_TAPS - 1; i++)
+	{
+		line[i] = history[i];
+	}
+
+	const uint32_t * const tapPairs = (const uint32_t *) taps;
+	for (uint16_t n = 0; n < count; n++)
+	{
+		//The window ends at input[n], it starts on a halfword boundary every other sample
+		const THalfwordPair * const window = (const THalfwordPair *) &line[n];
+		int32_t accumulator = 0;
+		for (uint8_t pair = 0; pair < FIR_TAPS / 2; pair++)
+		{
+			accumulator = Smlad(window[pair].pair, tapPairs[pair], accumulator);
+		}
+		output[n] = Saturate(accumulator, 15);
+	}
+
+	for (uint8_t i = 0; i < FIR_TAPS - 1; i++)
+	{
+		history[i] = line[count + i];
+	}
+}
+
+/*!
+ * @brief Run a biquad over a block of one axis.
+ * @param c The coefficients.
+ * @param x1 The last input, updated.
+ * @param x2 The input before that, updated.
+ * @param y1 The last output, updated.
+ * @param y2 The output before that, updated.
+ * @param input The block.
+ * @param count The number of samples in the block.
+ * @param output The filtered block.
+ */
+static void Biquad(const TBiquadCoefficients * const c, int32_t * const x1, int32_t * const x2, int32_t * const y1, int32_t * const y2,
+		const int16_t * const input, const uint16_t count, int16_t * const output)
+{
+	int32_t xn1 = *x1, xn2 = *x2, yn1 = *y1, yn2 = *y2;
+	for (uint16_t n = 0; n < count; n++)
+	{
+		int32_t x0 = (int32_t) input[n] << BIQUAD_STATE_SHIFT;
+		//Each product is a single SMLAL
+		int64_t accumulator = (int64_t) c->b0 * x0;
+		accumulator += (int64_t) c->b1 * xn1;
+		accumulator += (int64_t) c->b2 * xn2;
+		accumulator += (int64_t) c->a1 * yn1;
+		accumulator += (int64_t) c->a2 * yn2;
+		int32_t y0 = (int32_t) (accumulator >> 30);
+
+		xn2 = xn1;
+		xn1 = x0;
+		yn2 = yn1;
+		yn1 = y0;
+		output[n] = Saturate(y0, BIQUAD_STATE_SHIFT);
+	}
+	*x1 = xn1;
+	*x2 = xn2;
+	*y1 = yn1;
+	*y2 = yn2;
+}
+
+/*!
+ * @brief Keep every factor-th sample of each axis.
+ * @param phase Samples until the next one kept, updated.
+ * @param factor The decimation factor.
+ * @param input The blocks.
+ * @param count The number of samples in each block.
+ * @param output The decimated blocks.
+ * @return The number of samples kept.
+ */
+static uint16_t Decimate(uint8_t * const phase, const uint8_t factor, int16_t * const input[3], const uint16_t count, int16_t * const output[3])
+{
+	uint16_t kept = 0;
+	for (uint16_t n = 0; n < count; n++)
+	{
+		if (*phase == 0)
+		{
+			for (uint8_t axis = 0; axis < 3; axis++)
+			{
+				output[axis][kept] = input[axis][n];
+			}
+			kept++;
+		}
+		*phase = (*phase + 1 == factor) ? 0 : *phase + 1;
+	}
+	return kept;
+}
+
+/*!
+ * @brief Run one stage over the blocks of each axis.
+ * @param state The stage.
+ * @param input The blocks, with FIR_TAPS - 1 free entries in front of each.
+ * @param count The number of samples in each block.
+ * @param output The processed blocks.
+ * @return The number of samples in each processed block.
+ */
+static uint16_t RunStage(TStageState * const state, int16_t * const input[3], const uint16_t count, int16_t * const output[3])
+{
+	switch (state->stage)
+	{
+	case DSP_STAGE_FIR_LOWPASS:
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			Fir(LowpassTaps, state->state.history[axis], input[axis], count, output[axis]);
+		}
+		return count;
+	case DSP_STAGE_BIQUAD_LOWPASS:
+	case DSP_STAGE_BIQUAD_HIGHPASS:
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			Biquad((state->stage == DSP_STAGE_BIQUAD_LOWPASS) ? &LowpassBiquad : &HighpassBiquad,
+					&state->state.biquad[axis].x1, &state->state.biquad[axis].x2,
+					&state->state.biquad[axis].y1, &state->state.biquad[axis].y2,
+					input[axis], count, output[axis]);
+		}
+		return count;
+	case DSP_STAGE_DECIMATE_2:
+		return Decimate(&state->state.phase, 2, input, count, output);
+	case DSP_STAGE_DECIMATE_4:
+		return Decimate(&state->state.phase, 4, input, count, output);
+	default:
+		return count;
+	}
+}
+
+BOOL Dsp_Init()
+{
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		Stages[i] = DSP_STAGE_NONE;
+	}
+	StagesChanged = bTRUE;
+	return bTRUE;
+}
+
+BOOL Dsp_SetStage(const uint8_t index, const TDspStage stage)
+{
+	if ((index >= DSP_STAGES_MAX) || (stage > DSP_STAGE_DECIMATE_4))
+	{
+		return bFALSE;
+	}
+	Stages[index] = stage;
+	StagesChanged = bTRUE;
+	return bTRUE;
+}
+
+TDspStage Dsp_GetStage(const uint8_t index)
+{
+	return (index < DSP_STAGES_MAX) ? Stages[index] : DSP_STAGE_NONE;
+}
+
+uint16_t Dsp_Process(const TAccelSample * const input, const uint16_t count, TAccelSample * const output)
+{
+	if (StagesChanged)
+	{
+		StagesChanged = bFALSE;
+		ClearStages();
+	}
+
+	//Split the axes, each block starts after the room for the FIR history
+	uint8_t line = 0;
+	int16_t *blocks[2][3];
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		blocks[0][axis] = &Lines[0][axis][FIR_TAPS - 1];
+		blocks[1][axis] = &Lines[1][axis][FIR_TAPS - 1];
+		for (uint16_t n = 0; n < count; n++)
+		{
+			blocks[0][axis][n] = input[n].axes[axis];
+		}
+	}
+
+	uint16_t remaining = count;
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		if (States[i].stage == DSP_STAGE_NONE)
+		{
+			continue;
+		}
+		uint32_t start = BENCH_CYCLES();
+		uint16_t processed = RunStage(&States[i], blocks[line], remaining, blocks[line ^ 1]);
+		uint32_t cycles = BENCH_CYCLES() - start;
+
+		EnterCritical();
+		Statistics.cycles[i] += cycles;
+		Statistics.samples[i] += remaining;
+		ExitCritical();
+
+		remaining = processed;
+		line ^= 1;
+	}
+
+	for (uint16_t n = 0; n < remaining; n++)
+	{
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			output[n].axes[axis] = blocks[line][axis][n];
+		}
+	}
+	return remaining;
+}
+
+void Dsp_GetStatistics(TDspStatistics * const statistics)
+{
+	EnterCritical();
+	*statistics = Statistics;
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		Statistics.cycles[i] = 0;
+		Statistics.samples[i] = 0;
+	}
+	ExitCritical();
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,97 @@
+/*! @file
+ *
+ *  @brief Fixed-point filter pipeline for the accelerometer samples.
+ *
+ *  A chain of up to DSP_STAGES_MAX stages, each a FIR or biquad filter or a decimator,
+ *  run over blocks of samples. Each axis is filtered on its own.
+ *  The FIR stages use Q15 taps with SMLAD, the biquad stages Q30 coefficients with SMLAL.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-14
+ */
+/*!
+**  @addtogroup dsp_module DSP module documentation
+**  @{
+*/
+#ifndef DSP_H
+#define DSP_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Number of stages in the pipeline.
+ */
+#define DSP_STAGES_MAX 4
+
+/*!
+ * @brief Most samples processed in one call to Dsp_Process.
+ */
+#define DSP_BLOCK_MAX 128
+
+/*!
+ * @brief The stages available, frequencies are fractions of the sample rate (fs).
+ */
+typedef enum
+{
+  DSP_STAGE_NONE = 0,               /*!< Passes the samples through. */
+  DSP_STAGE_FIR_LOWPASS = 1,        /*!< 15 tap Hamming windowed low-pass FIR, cutoff fs / 8. */
+  DSP_STAGE_BIQUAD_LOWPASS = 2,     /*!< Butterworth low-pass biquad, cutoff fs / 20. */
+  DSP_STAGE_BIQUAD_HIGHPASS = 3,    /*!< Butterworth high-pass biquad, cutoff fs / 100, removes gravity. */
+  DSP_STAGE_DECIMATE_2 = 4,         /*!< Keeps every second sample. */
+  DSP_STAGE_DECIMATE_4 = 5          /*!< Keeps every fourth sample, put after DSP_STAGE_FIR_LOWPASS. */
+} TDspStage;
+
+/*!
+ * @brief Time spent in each stage.
+ */
+typedef struct
+{
+  uint32_t cycles[DSP_STAGES_MAX];    /*!< Cycles spent in the stage. */
+  uint32_t samples[DSP_STAGES_MAX];   /*!< Samples into the stage. */
+} TDspStatistics;
+
+/*! @brief Sets up the pipeline with every stage set to DSP_STAGE_NONE.
+ *
+ *  @return BOOL - TRUE if the pipeline was successfully initialized.
+ */
+BOOL Dsp_Init();
+
+/*! @brief Sets one stage of the pipeline.
+ *
+ *  The filter state of every stage is cleared, at the next call to Dsp_Process.
+ *  @param index The stage, 0 runs first.
+ *  @param stage The stage to put there.
+ *  @return BOOL - TRUE if the index and stage are valid.
+ */
+BOOL Dsp_SetStage(const uint8_t index, const TDspStage stage);
+
+/*!
+ * @brief Gets one stage of the pipeline.
+ * @param index The stage, 0 runs first.
+ * @return TDspStage
+ */
+TDspStage Dsp_GetStage(const uint8_t index);
+
+/*! @brief Runs a block of samples through the pipeline.
+ *
+ *  @param input The samples.
+ *  @param count The number of samples, at most DSP_BLOCK_MAX.
+ *  @param output Filled with the filtered samples, room for count is needed.
+ *  @return uint16_t The number of samples in output, fewer than count after decimation.
+ */
+uint16_t Dsp_Process(const TAccelSample * const input, const uint16_t count, TAccelSample * const output);
+
+/*! @brief Reads and clears the time spent in each stage.
+ *
+ *  @param statistics is filled with the time since the last call.
+ */
+void Dsp_GetStatistics(TDspStatistics * const statistics);
+
+#endif
+
+/*!
+** @}
+*/
@@ -0,0 +1,293 @@
+/*! @file
+ *
+ *  @brief Implementation of the fixed-point FFT.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-15
+ */
+/*!
+**  @addtogroup fft_module FFT module documentation
+**  @{
+*/
+#include "fft.h"
+
+#include "fixed.h"
+
+/*!
+ * @brief Points in a whole turn of SineTable, twice FFT_SIZE_MAX for the Hann window.
+ */
+#define SINE_POINTS 2048
+
+/*!
+ * @brief First quarter of a sine in Q15, sin(2 pi i / SINE_POINTS).
+ */
+static const int16_t SineTable[SINE_POINTS / 4 + 1] = {
+		0, 101, 201, 302, 402, 503, 603, 704, 804, 905, 1005, 1106,
+		1206, 1307, 1407, 1507, 1608, 1708, 1809, 1909, 2009, 2110, 2210, 2310,
+		2411, 2511, 2611, 2711, 2811, 2912, 3012, 3112, 3212, 3312, 3412, 3512,
+		3612, 3712, 3812, 3911, 4011, 4111, 4211, 4310, 4410, 4510, 4609, 4709,
+		4808, 4907, 5007, 5106, 5205, 5305, 5404, 5503, 5602, 5701, 5800, 5899,
+		5998, 6097, 6195, 6294, 6393, 6491, 6590, 6688, 6787, 6885, 6983, 7081,
+		7180, 7278, 7376, 7473, 7571, 7669, 7767, 7864, 7962, 8059, 8157, 8254,
+		8351, 8449, 8546, 8643, 8740, 8836, 8933, 9030, 9127, 9223, 9319, 9416,
+		9512, 9608, 9704, 9800, 9896, 9992, 10088, 10183, 10279, 10374, 10469, 10565,
+		10660, 10755, 10850, 10945, 11039, 11134, 11228, 11323, 11417, 11511, 11605, 11699,
+		11793, 11887, 11980, 12074, 12167, 12261, 12354, 12447, 12540, 12633, 12725, 12818,
+		12910, 13003, 13095, 13187, 13279, 13371, 13463, 13554, 13646, 13737, 13828, 13919,
+		14010, 14101, 14192, 14282, 14373, 14463, 14553, 14643, 14733, 14823, 14912, 15002,
+		15091, 15180, 15269, 15358, 15447, 15535, 15624, 15712, 15800, 15888, 15976, 16064,
+		16151, 16239, 16326, 16413, 16500, 16587, 16673, 16760, 16846, 16932, 17018, 17104,
+		17190, 17275, 17361, 17446, 17531, 17616, 17700, 17785, 17869, 17953, 18037, 18121,
+		18205, 18288, 18372, 18455, 18538, 18621, 18703, 18786, 18868, 18950, 19032, 19114,
+		19195, 19277, 19358, 19439, 19520, 19601, 19681, 19761, 19841, 19921, 20001, 20081,
+		20160, 20239, 20318, 20397, 20475, 20554, 20632, 20710, 20788, 20865, 20943, 21020,
+		21097, 21174, 21251, 21327, 21403, 21479, 21555, 21631, 21706, 21781, 21856, 21931,
+		22006, 22080, 22154, 22228, 22302, 22375, 22449, 22522, 22595, 22668, 22740, 22812,
+		22884, 22956, 23028, 23099, 23170, 23241, 23312, 23383, 23453, 23523, 23593, 23663,
+		23732, 23801, 23870, 23939, 24008, 24076, 24144, 24212, 24279, 24347, 24414, 24481,
+		24548, 24614, 24680, 24746, 24812, 24878, 24943, 25008, 25073, 25138, 25202, 25266,
+		25330, 25394, 25457, 25520, 25583, 25646, 25708, 25771, 25833, 25894, 25956, 26017,
+		26078, 26139, 26199, 26259, 26320, 26379, 26439, 26498, 26557, 26616, 26674, 26733,
+		26791, 26848, 26906, 26963, 27020, 27077, 27133, 27190, 27246, 27301, 27357, 27412,
+		27467, 27522, 27576, 27630, 27684, 27738, 27791, 27844, 27897, 27950, 28002, 28054,
+		28106, 28158, 28209, 28260, 28311, 28361, 28411, 28461, 28511, 28560, 28610, 28658,
+		28707, 28755, 28803, 28851, 28899, 28946, 28993, 29040, 29086, 29132, 29178, 29224,
+		29269, 29314, 29359, 29404, 29448, 29492, 29535, 29579, 29622, 29665, 29707, 29750,
+		29792, 29833, 29875, 29916, 29957, 29997, 30038, 30078, 30118, 30157, 30196, 30235,
+		30274, 30312, 30350, 30388, 30425, 30462, 30499, 30536, 30572, 30608, 30644, 30680,
+		30715, 30750, 30784, 30819, 30853, 30886, 30920, 30953, 30986, 31018, 31050, 31082,
+		31114, 31146, 31177, 31207, 31238, 31268, 31298, 31328, 31357, 31386, 31415, 31443,
+		31471, 31499, 31527, 31554, 31581, 31608, 31634, 31660, 31686, 31711, 31737, 31761,
+		31786, 31810, 31834, 31858, 31881, 31904, 31927, 31950, 31972, 31994, 32015, 32037,
+		32058, 32078, 32099, 32119, 32138, 32158, 32177, 32196, 32214, 32233, 32251, 32268,
+		32286, 32303, 32319, 32336, 32352, 32368, 32383, 32398, 32413, 32428, 32442, 32456,
+		32470, 32483, 32496, 32509, 32522, 32534, 32546, 32557, 32568, 32579, 32590, 32600,
+		32610, 32620, 32629, 32638, 32647, 32656, 32664, 32672, 32679, 32686, 32693, 32700,
+		32706, 32712, 32718, 32723, 32729, 32733, 32738, 32742, 32746, 32749, 32753, 32756,
+		32758, 32760, 32762, 32764, 32766, 32767, 32767, 32767, 32767
+
+};
+
+/*!
+ * @brief The sine of an angle.
+ * @param index The angle in SINE_POINTS per turn, 0 to SINE_POINTS - 1.
+ * @return The sine in Q15.
+ */
+static int16_t Sine(const uint16_t index)
+{
+	uint16_t quarter = index % (SINE_POINTS / 2);
+	if (quarter > SINE_POINTS / 4)
+	{
+		quarter = SINE_POINTS / 2 - quarter;
+	}
+	return (index < SINE_POINTS / 2) ? SineTable[quarter] : -SineTable[quarter];
+}
+
+/*!
+ * @brief The cosine of an angle.
+ * @param index The angle in SINE_POINTS per turn, 0 to SINE_POINTS - 1.
+ * @return The cosine in Q15.
+ */
+static int16_t Cosine(const uint16_t index)
+{
+	return Sine((index + SINE_POINTS / 4) % SINE_POINTS);
+}
+
+/*!
+ * @brief One radix-2 stage of the decimation in time FFT, halving the values.
+ * @param data Interleaved real and imaginary parts, in the order the earlier stages left them.
+ * @param points The number of complex points, a power of 2.
+ * @param span Distance between the two inputs of a butterfly.
+ */
+static void Radix2Pass(int16_t * const data, const uint16_t points, const uint16_t span)
+{
+	//Twiddle step for this stage, the twiddles are e^(-j pi k / span)
+	uint16_t step = SINE_POINTS / (2 * span);
+	for (uint16_t k = 0; k < span; k++)
+	{
+		int32_t c = Cosine(k * step);
+		int32_t s = Sine(k * step);
+		for (uint16_t i = k; i < points; i += 2 * span)
+		{
+			int16_t * const a = &data[2 * i];
+			int16_t * const b = &data[2 * (i + span)];
+			int32_t tr = (b[0] * c + b[1] * s) >> 15;
+			int32_t ti = (b[1] * c - b[0] * s) >> 15;
+			int32_t ar = a[0];
+			int32_t ai = a[1];
+			a[0] = (int16_t) ((ar + tr) >> 1);
+			a[1] = (int16_t) ((ai + ti) >> 1);
+			b[0] = (int16_t) ((ar - tr) >> 1);
+			b[1] = (int16_t) ((ai - ti) >> 1);
+		}
+	}
+}
+
+#if FFT_RADIX == 4
+/*!
+ * @brief Two radix-2 stages done as one radix-4 pass, quartering the values.
+ *
+ * The inputs are in bit reversed order, so the second and third quarters are the other way round
+ * from the usual radix-4 butterfly. Takes 3 complex multiplies a butterfly instead of 4,
+ * and one load and store of each point instead of two.
+ * @param data Interleaved real and imaginary parts, in the order the earlier stages left them.
+ * @param points The number of complex points, a power of 2.
+ * @param span Distance between the four inputs of a butterfly.
+ */
+static void Radix4Pass(int16_t * const data, const uint16_t points, const uint16_t span)
+{
+	//The twiddles are e^(-j pi k / (2 span)) and its square and cube
+	uint16_t step = SINE_POINTS / (4 * span);
+	for (uint16_t k = 0; k < span; k++)
+	{
+		int32_t c1 = Cosine(k * step);
+		int32_t s1 = Sine(k * step);
+		int32_t c2 = Cosine(2 * k * step);
+		int32_t s2 = Sine(2 * k * step);
+		int32_t c3 = Cosine(3 * k * step);
+		int32_t s3 = Sine(3 * k * step);
+		for (uint16_t i = k; i < points; i += 4 * span)
+		{
+			int16_t * const x0 = &data[2 * i];
+			int16_t * const x1 = &data[2 * (i + span)];
+			int16_t * const x2 = &data[2 * (i + 2 * span)];
+			int16_t * const x3 = &data[2 * (i + 3 * span)];
+			int32_t ar = (x1[0] * c2 + x1[1] * s2) >> 15;
+			int32_t ai = (x1[1] * c2 - x1[0] * s2) >> 15;
+			int32_t br = (x2[0] * c1 + x2[1] * s1) >> 15;
+			int32_t bi = (x2[1] * c1 - x2[0] * s1) >> 15;
+			int32_t dr = (x3[0] * c3 + x3[1] * s3) >> 15;
+			int32_t di = (x3[1] * c3 - x3[0] * s3) >> 15;
+
+			int32_t t0r = x0[0] + ar;
+			int32_t t0i = x0[1] + ai;
+			int32_t t1r = x0[0] - ar;
+			int32_t t1i = x0[1] - ai;
+			int32_t t2r = br + dr;
+			int32_t t2i = bi + di;
+			int32_t t3r = br - dr;
+			int32_t t3i = bi - di;
+
+			x0[0] = (int16_t) ((t0r + t2r) >> 2);
+			x0[1] = (int16_t) ((t0i + t2i) >> 2);
+			x2[0] = (int16_t) ((t0r - t2r) >> 2);
+			x2[1] = (int16_t) ((t0i - t2i) >> 2);
+			//t1 -/+ j t3
+			x1[0] = (int16_t) ((t1r + t3i) >> 2);
+			x1[1] = (int16_t) ((t1i - t3r) >> 2);
+			x3[0] = (int16_t) ((t1r - t3i) >> 2);
+			x3[1] = (int16_t) ((t1i + t3r) >> 2);
+		}
+	}
+}
+#endif
+
+/*!
+ * @brief In place decimation in time FFT, the values are divided by the number of points.
+ * @param data Interleaved real and imaginary parts.
+ * @param points The number of complex points, a power of 2.
+ */
+static void ComplexFft(int16_t * const data, const uint16_t points)
+{
+	//Bit reversed order
+	for (uint16_t i = 1, j = 0; i < points; i++)
+	{
+		uint16_t bit = points >> 1;
+		for (; j & bit; bit >>= 1)
+		{
+			j ^= bit;
+		}
+		j |= bit;
+		if (i < j)
+		{
+			int16_t re = data[2 * i];
+			int16_t im = data[2 * i + 1];
+			data[2 * i] = data[2 * j];
+			data[2 * i + 1] = data[2 * j + 1];
+			data[2 * j] = re;
+			data[2 * j + 1] = im;
+		}
+	}
+
+	uint16_t span = 1;
+#if FFT_RADIX == 4
+	//An odd number of stages starts with a radix-2 one
+	if (points & 0xAAAA)
+	{
+		Radix2Pass(data, points, span);
+		span <<= 1;
+	}
+	for (; span < points; span <<= 2)
+	{
+		Radix4Pass(data, points, span);
+	}
+#else
+	for (; span < points; span <<= 1)
+	{
+		Radix2Pass(data, points, span);
+	}
+#endif
+}
+
+void Fft_HannWindow(int16_t * const data, const uint16_t size, const uint8_t shift)
+{
+	//w(n) = sin^2(pi n / size)
+	uint16_t step = SINE_POINTS / (2 * size);
+	for (uint16_t n = 0; n < size; n++)
+	{
+		int32_t s = Sine(n * step);
+		int32_t w = (s * s) >> 15;
+		//Shifted after the multiply so it can't overflow, then saturated as a sample past the headroom wraps
+		int32_t value = ((int32_t) data[n] * w) >> (15 - shift);
+		if (value > INT16_MAX)
+		{
+			value = INT16_MAX;
+		}
+		else if (value < INT16_MIN)
+		{
+			value = INT16_MIN;
+		}
+		data[n] = (int16_t) value;
+	}
+}
+
+BOOL Fft_RealMagnitudes(int16_t * const data, const uint16_t size, uint16_t * const magnitudes)
+{
+	if ((size < FFT_SIZE_MIN) || (size > FFT_SIZE_MAX) || (size & (size - 1)))
+	{
+		return bFALSE;
+	}
+
+	//Even samples as the real parts, odd as the imaginary
+	uint16_t points = size / 2;
+	ComplexFft(data, points);
+
+	//Split Z into X[k] = (Z[k] + Z*[M - k]) / 2 - j W^k (Z[k] - Z*[M - k]) / 2, then halve once more
+	uint16_t step = SINE_POINTS / size;
+	for (uint16_t k = 0; k <= points; k++)
+	{
+		uint16_t i = (k == points) ? 0 : k;
+		uint16_t m = (k == 0) ? 0 : points - k;
+		int32_t zr = data[2 * i];
+		int32_t zi = data[2 * i + 1];
+		int32_t cr = data[2 * m];
+		int32_t ci = -data[2 * m + 1];
+
+		int32_t er = zr + cr;
+		int32_t ei = zi + ci;
+		//-j (Z - Z*)
+		int32_t odr = zi - ci;
+		int32_t odi = -(zr - cr);
+
+		int32_t c = Cosine(k * step % SINE_POINTS);
+		int32_t s = Sine(k * step % SINE_POINTS);
+		int32_t xr = (er + ((odr * c + odi * s) >> 15)) >> 2;
+		int32_t xi = (ei + ((odi * c - odr * s) >> 15)) >> 2;
+		magnitudes[k] = Fixed_SquareRoot((uint32_t) (xr * xr + xi * xi));
+	}
+	return bTRUE;
+}
+
+/*!
+** @}
+*/
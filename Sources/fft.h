@@ -0,0 +1,64 @@
+/*! @file
+ *
+ *  @brief Fixed-point FFT of real signals.
+ *
+ *  A complex FFT of half the length followed by a split into the real spectrum.
+ *  Each stage halves the values so nothing can overflow, the spectrum comes out divided by the length.
+ *  Tests/fft_test.c checks it against a double precision DFT on the host.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-15
+ */
+/*!
+**  @addtogroup fft_module FFT module documentation
+**  @{
+*/
+#ifndef FFT_H
+#define FFT_H
+
+// new types
+#include "types.h"
+
+/*!
+ * @brief Shortest transform, in real samples.
+ */
+#define FFT_SIZE_MIN 16
+
+/*!
+ * @brief Longest transform, in real samples.
+ */
+#define FFT_SIZE_MAX 1024
+
+/*!
+ * @brief Radix of the complex FFT passes, 4 (with a radix-2 pass for an odd number of stages) or 2.
+ * Build with -DFFT_RADIX=2 to compare the two with BENCH_FFT.
+ */
+#ifndef FFT_RADIX
+#define FFT_RADIX 4
+#endif
+
+/*! @brief Multiplies a block by a Hann window.
+ *
+ *  @param data The samples, windowed in place.
+ *  @param size The number of samples, a power of 2 from FFT_SIZE_MIN to FFT_SIZE_MAX.
+ *  @param shift Left shift applied to the samples, to use the headroom of smaller samples, at most 15.
+ *    Windowed samples which no longer fit are saturated.
+ */
+void Fft_HannWindow(int16_t * const data, const uint16_t size, const uint8_t shift);
+
+/*! @brief Transforms a real signal and takes the magnitude of each bin.
+ *
+ *  A full scale sine at the centre of a bin gives a magnitude of half its amplitude,
+ *  a Hann window halves that again.
+ *  @param data The samples, destroyed.
+ *  @param size The number of samples, a power of 2 from FFT_SIZE_MIN to FFT_SIZE_MAX.
+ *  @param magnitudes Filled with the magnitudes of bins 0 to size / 2.
+ *  @return BOOL - TRUE if the size is valid.
+ */
+BOOL Fft_RealMagnitudes(int16_t * const data, const uint16_t size, uint16_t * const magnitudes);
+
+#endif
+
+/*!
+** @}
+*/
@@ -0,0 +1,142 @@
+/*! @file
+ *
+ *  @brief Implementation of the accelerometer sample filtering.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-13
+ */
+/*!
+**  @addtogroup filter_module Filter module documentation
+**  @{
+*/
+#include "filter.h"
+
+#include "history.h"
+#include "median.h"
+
+/*!
+ * @brief A median filter for each axis.
+ */
+static TMedianFilter Medians[3];
+
+/*!
+ * @brief Number of samples in the history, the power of 2 above MEDIAN_WINDOW_MAX.
+ */
+#define FILTER_HISTORY_SIZE 64
+
+/*!
+ * @brief Storage of History.
+ */
+static TAccelSample HistorySamples[FILTER_HISTORY_SIZE];
+
+/*!
+ * @brief The samples in since the filters were set up.
+ */
+static THistory History;
+
+/*!
+ * @brief The median window, changes are picked up by the next sample.
+ */
+static volatile uint8_t MedianWindow = FILTER_DEFAULT_MEDIAN_WINDOW;
+
+/*!
+ * @brief Median window the filters were set up with.
+ */
+static uint8_t FilterWindow;
+
+/*!
+ * @brief Sample period the filters were filled at.
+ */
+static uint32_t FilterPeriod;
+
+/*!
+ * @brief Range the filters were filled at.
+ */
+static TAccelRange FilterRange;
+
+/*!
+ * @brief Empty the filters and remember the settings they are filled at.
+ */
+static void Restart()
+{
+	FilterWindow = MedianWindow;
+	FilterPeriod = Accel_GetSamplePeriod();
+	FilterRange = Accel_GetRange();
+	History_Clear(&History);
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		(void) Median_Init(&Medians[axis], FilterWindow);
+	}
+}
+
+/*!
+ * @brief Median filter with a window of 3 over the newest samples in the history, all three axes at once.
+ * @param filtered Set to the median of each axis.
+ */
+static void FilterPacked3(TAccelSample * const filtered)
+{
+	//Until there are 3, the oldest stands in for the rest, so the first sample passes straight through
+	const TAccelSample *s[3];
+	for (uint16_t age = 0; age < 3; age++)
+	{
+		s[age] = History_Get(&History, (age < History.Count) ? age : History.Count - 1);
+	}
+
+	uint32_t xy = Median_Filter3Packed(MEDIAN_PACK(s[0]->axes[ACCEL_X], s[0]->axes[ACCEL_Y]),
+			MEDIAN_PACK(s[1]->axes[ACCEL_X], s[1]->axes[ACCEL_Y]),
+			MEDIAN_PACK(s[2]->axes[ACCEL_X], s[2]->axes[ACCEL_Y]));
+	uint32_t z = Median_Filter3Packed(MEDIAN_PACK(s[0]->axes[ACCEL_Z], 0),
+			MEDIAN_PACK(s[1]->axes[ACCEL_Z], 0),
+			MEDIAN_PACK(s[2]->axes[ACCEL_Z], 0));
+	filtered->axes[ACCEL_X] = MEDIAN_UNPACK_LOW(xy);
+	filtered->axes[ACCEL_Y] = MEDIAN_UNPACK_HIGH(xy);
+	filtered->axes[ACCEL_Z] = MEDIAN_UNPACK_LOW(z);
+}
+
+BOOL Filter_Init()
+{
+	MedianWindow = FILTER_DEFAULT_MEDIAN_WINDOW;
+	(void) History_Init(&History, HistorySamples, FILTER_HISTORY_SIZE);
+	Restart();
+	return bTRUE;
+}
+
+BOOL Filter_SetMedianWindow(const uint8_t window)
+{
+	if ((window < MEDIAN_WINDOW_MIN) || (window > MEDIAN_WINDOW_MAX))
+	{
+		return bFALSE;
+	}
+	//The filtering thread sets the filters up again, so they don't change under it
+	MedianWindow = window;
+	return bTRUE;
+}
+
+uint8_t Filter_GetMedianWindow()
+{
+	return MedianWindow;
+}
+
+void Filter_Sample(const TAccelSample * const sample, TAccelSample * const filtered)
+{
+	//Samples from before a rate or range change would hold the median back, start again from this one
+	if ((FilterWindow != MedianWindow) || (FilterPeriod != Accel_GetSamplePeriod()) || (FilterRange != Accel_GetRange()))
+	{
+		Restart();
+	}
+
+	History_Push(&History, sample);
+	if (FilterWindow == 3)
+	{
+		FilterPacked3(filtered);
+		return;
+	}
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		filtered->axes[axis] = Median_Update(&Medians[axis], sample->axes[axis]);
+	}
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,61 @@
+/*! @file
+ *
+ *  @brief Filtering of the accelerometer samples before they are sent.
+ *
+ *  Each axis is median filtered over a sliding window of samples,
+ *  the window is set at runtime. A window of 3 filters all three axes at once
+ *  with the packed median.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-13
+ */
+/*!
+**  @addtogroup filter_module Filter module documentation
+**  @{
+*/
+#ifndef FILTER_H
+#define FILTER_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Median window used until Filter_SetMedianWindow is called.
+ */
+#define FILTER_DEFAULT_MEDIAN_WINDOW 3
+
+/*! @brief Sets up the filter with the default window and no samples in it.
+ *
+ *  @return BOOL - TRUE if the filter was successfully initialized.
+ */
+BOOL Filter_Init();
+
+/*! @brief Sets the number of samples each median is taken over.
+ *
+ *  The samples already in the filter are discarded.
+ *  @param window The window, MEDIAN_WINDOW_MIN to MEDIAN_WINDOW_MAX.
+ *  @return BOOL - TRUE if the window is valid.
+ */
+BOOL Filter_SetMedianWindow(const uint8_t window);
+
+/*!
+ * @brief Gets the number of samples each median is taken over.
+ * @return uint8_t
+ */
+uint8_t Filter_GetMedianWindow();
+
+/*! @brief Adds a sample to the filter.
+ *
+ *  A change of the accelerometer data rate or range discards the earlier samples.
+ *  @param sample The new sample.
+ *  @param filtered Set to the median of each axis.
+ */
+void Filter_Sample(const TAccelSample * const sample, TAccelSample * const filtered);
+
+#endif
+
+/*!
+** @}
+*/
@@ -0,0 +1,46 @@
+/*! @file
+ *
+ *  @brief Fixed-point maths.
+ *
+ *  Integer replacements for the libm functions the signal processing needs.
+ *  Angles are binary, FIXED_ANGLE_TURN to a whole turn, so they wrap like the integers holding them.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-16
+ */
+/*!
+**  @addtogroup fixed_module Fixed-point module documentation
+**  @{
+*/
+#ifndef FIXED_H
+#define FIXED_H
+
+// new types
+#include "types.h"
+
+/*! @brief Integer square root.
+ *
+ *  @param value The value.
+ *  @return uint16_t The square root, rounded down.
+ */
+uint16_t Fixed_SquareRoot(uint32_t value);
+
+/*!
+ * @brief A whole turn (360 degrees) as a binary angle, half a turn is INT16_MIN as an int16_t.
+ */
+#define FIXED_ANGLE_TURN 65536LU
+
+/*! @brief Angle of the vector (x, y), as atan2 from libm.
+ *
+ *  Interpolates a table of the first octant, the error is below 0.01 degrees.
+ *  @param y The y component, at most 65535 in size.
+ *  @param x The x component, at most 65535 in size.
+ *  @return int16_t The binary angle from the x axis, 0 when both are 0.
+ */
+int16_t Fixed_Atan2(const int32_t y, const int32_t x);
+
+#endif
+
+/*!
+** @}
+*/
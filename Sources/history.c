@@ -0,0 +1,53 @@
+/*! @file
+ *
+ *  @brief Implementation of the sample history.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-19
+ */
+/*!
+**  @addtogroup history_module History module documentation
+**  @{
+*/
+#include "history.h"
+
+BOOL History_Init(THistory * const history, TAccelSample * const samples, const uint16_t size)
+{
+	if ((size == 0) || (size & (size - 1)))
+	{
+		return bFALSE;
+	}
+	history->Samples = samples;
+	history->Size = size;
+	History_Clear(history);
+	return bTRUE;
+}
+
+void History_Clear(THistory * const history)
+{
+	history->Count = 0;
+	history->Next = 0;
+}
+
+void History_Push(THistory * const history, const TAccelSample * const sample)
+{
+	history->Samples[history->Next] = *sample;
+	history->Next = (history->Next + 1) & (history->Size - 1);
+	if (history->Count < history->Size)
+	{
+		history->Count++;
+	}
+}
+
+const TAccelSample *History_Get(const THistory * const history, const uint16_t age)
+{
+	if (age >= history->Count)
+	{
+		return NULL;
+	}
+	return &history->Samples[(history->Next - 1 - age) & (history->Size - 1)];
+}
+
+/*!
+** @}
+*/
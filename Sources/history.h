@@ -0,0 +1,69 @@
+/*! @file
+ *
+ *  @brief History of the last accelerometer samples.
+ *
+ *  A circular buffer which overwrites its oldest sample, so a push is a copy and an index,
+ *  whatever the length. Samples are read back by age, 0 being the newest.
+ *  The storage is given by the user, so each history can be as long as it needs.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-19
+ */
+/*!
+**  @addtogroup history_module History module documentation
+**  @{
+*/
+#ifndef HISTORY_H
+#define HISTORY_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @struct THistory
+ */
+typedef struct
+{
+  TAccelSample *Samples;  /*!< The storage, Size samples. */
+  uint16_t Size;          /*!< Number of samples held, a power of 2. */
+  uint16_t Count;         /*!< Number of samples pushed, up to Size. */
+  uint16_t Next;          /*!< Index the next sample is pushed to. */
+} THistory;
+
+/*! @brief Initialize the history before first use.
+ *
+ *  @param history A pointer to the history that needs initializing.
+ *  @param samples The storage, Size samples.
+ *  @param size Number of samples in the storage, a power of 2.
+ *  @return BOOL - TRUE if the size is valid.
+ */
+BOOL History_Init(THistory * const history, TAccelSample * const samples, const uint16_t size);
+
+/*! @brief Forget every sample.
+ *
+ *  @param history A pointer to the history.
+ */
+void History_Clear(THistory * const history);
+
+/*! @brief Add a sample, the oldest is overwritten once the history is full.
+ *
+ *  @param history A pointer to the history.
+ *  @param sample The sample, copied into the history.
+ */
+void History_Push(THistory * const history, const TAccelSample * const sample);
+
+/*! @brief Get a sample by age.
+ *
+ *  @param history A pointer to the history.
+ *  @param age 0 for the newest sample, Count - 1 for the oldest.
+ *  @return const TAccelSample* - The sample, or NULL if there is no sample that old.
+ */
+const TAccelSample *History_Get(const THistory * const history, const uint16_t age);
+
+#endif
+
+/*!
+** @}
+*/
@@ -34,6 +34,7 @@
 #include "INT_PIT0.h"
 #include "INT_FTM0.h"
 #include "INT_I2C0.h"
+#include "INT_DMA0.h"
 #include "INT_PORTB.h"
 #include "INT_SysTick.h"
 #include "INT_PendableSrvReq.h"
@@ -46,24 +47,34 @@
 #include "IO_Map.h"
 
 #include "accel.h"
+#include "bench.h"
 #include "cmd.h"
+#include "dsp.h"
+#include "summary.h"
+#include "filter.h"
 #include "flash.h"
 #include "game.h"
+#include "history.h"
 #include "I2C.h"
 #include "LEDs.h"
-#include "median.h"
 #include "OS.h"
 #include "packet.h"
 #include "PIT.h"
 #include "random.h"
+#include "report.h"
 #include "RTC.h"
+#include "samples.h"
+#include "spectrum.h"
 #include "switch.h"
 #include "threads.h"
+#include "tilt.h"
 #include "timer.h"
 #include "timers.h"
 #include "toggle.h"
 #include "touch.h"
 #include "UART.h"
+#include "update.h"
+#include "wheel.h"
 
 typedef enum
 {
@@ -87,135 +98,332 @@ void BlueOff(void *arguments)
 	LEDs_Off(LED_BLUE);
 }
 
+/*!
+ * @brief Wakes the main thread, signaled whenever one of its flags is set or samples arrive.
+ */
+static OS_ECB *AccelSemaphore;
+
 /*!
  * @brief If asserted an accelerometer read should be scheduled.
  */
 static uint8_t PendingAccelReadFlag = 0;
 
 /*!
- * @brief Sets the PendingAccelReadFlag flag.
+ * @brief If asserted there are new accelerometer events available in AccEvents.
  */
-void QueueAccelRead(void *argument)
+static uint8_t NewAccelEventsFlag = 0;
+
+/*!
+ * @brief Destination of single sample reads, only touched in the I2C ISR.
+ */
+static TAccelSample AccSample;
+
+/*!
+ * @brief Destination of FIFO reads, only touched in the I2C ISR.
+ */
+static TAccelFIFO AccFIFO;
+
+/*!
+ * @brief Contains the events of the last event read.
+ */
+static TAccelEvents AccEvents;
+
+/*!
+ * @brief Samples on their way from the I2C ISR to the main thread.
+ */
+static TSampleRing AccRing;
+
+/*!
+ * @brief Cycle count when the last read was triggered, the time given to its samples.
+ */
+static volatile uint32_t ReadTriggerTime;
+
+/*!
+ * @brief Time before an accelerometer read is tried again, in ms.
+ */
+#define ACCEL_RETRY_TIME 10
+
+/*!
+ * @brief Called when the retry timer expires, has the main thread read again while the line is held.
+ */
+static void AccelRetry(void *arguments)
 {
-	PendingAccelReadFlag = 1;
+	if (Accel_InterruptAsserted())
+	{
+		ReadTriggerTime = BENCH_CYCLES();
+		PendingAccelReadFlag = 1;
+		(void) OS_SemaphoreSignal(AccelSemaphore);
+	}
 }
 
 /*!
- * @brief If asserted there is new accelerometer data available in AccReadData[3].
+ * @brief Timer run when a FIFO or event read couldn't be queued, or left the interrupt line held.
  */
-static uint8_t NewAccelDataFlag = 0;
+static TWheelTimer AccelRetryTimer = { NULL,
+		NULL,
+		0,
+		0,
+		&AccelRetry,
+		(void *) 0 };
 
 /*!
- * @brief Contains the freshest accelerometer data.
+ * @brief Queue the accelerometer read for the current mode.
+ *
+ * The FIFO and events are only read on an edge of the interrupt line,
+ * so if their read can't be queued it is tried again later.
  */
-static uint8_t AccReadData[3] = { 0 };
+static void StartAccelRead()
+{
+	BOOL queued = bTRUE;
+	switch (Accel_GetMode())
+	{
+	case ACCEL_FIFO:
+		queued = Accel_ReadFIFO(&AccFIFO);
+		break;
+	case ACCEL_EVENT:
+		queued = Accel_ReadEvents(&AccEvents);
+		break;
+	default:
+		Accel_ReadXYZ(&AccSample);
+		break;
+	}
+	if (!queued)
+	{
+		(void) Wheel_Start(&AccelRetryTimer, ACCEL_RETRY_TIME, 0);
+	}
+}
 
 /*!
- * @brief Callback after the accelerometer data is updated.
+ * @brief Called from the poll timer or data ready interrupt to read the accelerometer.
+ *
+ * In direct acquisition the read is queued straight away,
+ * the main thread only wakes once the samples have arrived.
+ * Otherwise the PendingAccelReadFlag flag is set and the main thread queues it.
  */
-void AccelReadCallback(void *data)
+void QueueAccelRead(void *argument)
 {
-	NewAccelDataFlag = 1;
+	ReadTriggerTime = BENCH_CYCLES();
+	if (Accel_GetAcquisition() == ACCEL_ACQUISITION_DIRECT)
+	{
+		StartAccelRead();
+		return;
+	}
+	PendingAccelReadFlag = 1;
+	(void) OS_SemaphoreSignal(AccelSemaphore);
 }
 
 /*!
- * @brief Shifts the elements of an array one to the left.
- * @param array The array to shift.
- * @param len The length of the array.
- * @param newVal The new value to insert at index 0.
+ * @brief Callback from the I2C ISR after an accelerometer read.
  */
-void ShiftArray(uint8_t * const array, const size_t len, const uint8_t newVal)
+void AccelReadCallback(void *data)
 {
-	for (size_t i = (len - 1); i > 0; i--)
+	//Timed from the interrupt which asked for the read, so the latency covers the whole chain
+	uint32_t time = ReadTriggerTime;
+	TAccelMode mode = Accel_GetMode();
+	switch (mode)
 	{
-		array[i] = array[i - 1];
+	case ACCEL_FIFO:
+	{
+		//Only the burst is timed, the earlier samples are one sample period apart
+		uint32_t period = Accel_GetSamplePeriod() * (CPU_CORE_CLK_HZ / 1000000);
+		for (uint8_t i = 0; i < AccFIFO.count; i++)
+		{
+			(void) Samples_Put(&AccRing, &AccFIFO.samples[i], time - (uint32_t) (AccFIFO.count - 1 - i) * period);
+		}
+		break;
 	}
-	array[0] = newVal;
+	case ACCEL_EVENT:
+		NewAccelEventsFlag = 1;
+		break;
+	default:
+		(void) Samples_Put(&AccRing, &AccSample, time);
+		break;
+	}
+	//A failed read leaves its source unread, holding the line without another edge
+	if (((mode == ACCEL_FIFO) || (mode == ACCEL_EVENT)) && Accel_InterruptAsserted())
+	{
+		(void) Wheel_Start(&AccelRetryTimer, ACCEL_RETRY_TIME, 0);
+	}
+	(void) OS_SemaphoreSignal(AccelSemaphore);
 }
 
 /*!
- * @brief The last bytes of accelerometer data which were sent.
+ * @brief Number of samples in the send history.
+ */
+#define ACCEL_SEND_HISTORY_SIZE 4
+
+/*!
+ * @brief Storage of AccelSendHistory.
  */
-static uint8_t AccelSendHistory[3] = { 0 };
+static TAccelSample AccelSendSamples[ACCEL_SEND_HISTORY_SIZE];
 
 /*!
- * @brief The last bytes of x read from the accelerometer in poll mode.
+ * @brief The last accelerometer samples which were sent.
  */
-static uint8_t AccelXHistory[3] = { 0 };
+static THistory AccelSendHistory;
 
 /*!
- * @brief The last bytes of y read from the accelerometer in poll mode.
+ * @brief Median filter a poll mode sample and send the result if it moved past the dead-band.
+ * @param sample The sample.
  */
-static uint8_t AccelYHistory[3] = { 0 };
+static void FilterSample(const TAccelSample * const sample)
+{
+	static const TAccelSample nothingSent;
+	TAccelSample median;
+	Filter_Sample(sample, &median);
+
+	const TAccelSample *sent = History_Get(&AccelSendHistory, 0);
+	if (Report_Check(&median, sent ? sent : &nothingSent))
+	{
+		History_Push(&AccelSendHistory, &median);
+		(void) CMD_SendAccelerometerValues(&median, 1);
+	}
+}
+
+/*!
+ * @brief Output of the filter pipeline.
+ */
+static TAccelSample PipelineOutput[DSP_BLOCK_MAX];
 
 /*!
- * @brief The last bytes of z read from the accelerometer in poll mode.
+ * @brief Peaks of the last spectrum frame.
  */
-static uint8_t AccelZHistory[3] = { 0 };
+static TSpectrumPeaks SpectrumPeaks;
 
 /*!
- * @brief Run on the main thread to handle new accelerometer data.
+ * @brief Summary of the last window.
+ */
+static TSummary WindowSummary;
+
+/*!
+ * @brief Run on the main thread to drain the accelerometer samples.
  */
 void HandleNewAccelData()
 {
-	if (Accel_GetMode() == ACCEL_INT)
+	const TAccelSample *samples;
+	const uint32_t *times;
+	uint16_t count;
+	//Twice at most, the second time for the part after the ring wraps
+	while ((count = Samples_Peek(&AccRing, &samples, &times)) != 0)
 	{
-		Packet_Put(0x10, AccReadData[0], AccReadData[1], AccReadData[2]);
-		return;
+		if (Accel_GetMode() == ACCEL_POLL)
+		{
+			for (uint16_t i = 0; i < count; i++)
+			{
+				FilterSample(&samples[i]);
+			}
+		}
+		else
+		{
+			uint16_t filtered = Dsp_Process(samples, count, PipelineOutput);
+			//The spectrum, the summaries and the angles are sent in place of the samples
+			BOOL summarised = bFALSE;
+			if (Spectrum_GetSize())
+			{
+				summarised = bTRUE;
+				for (uint16_t i = 0; i < filtered; i++)
+				{
+					if (Spectrum_Add(&PipelineOutput[i], &SpectrumPeaks))
+					{
+						(void) CMD_SendSpectrumPeaks(&SpectrumPeaks);
+					}
+				}
+			}
+			if (Summary_GetWindow())
+			{
+				summarised = bTRUE;
+				for (uint16_t i = 0; i < filtered; i++)
+				{
+					if (Summary_Add(&PipelineOutput[i], &WindowSummary))
+					{
+						(void) CMD_SendSummary(&WindowSummary);
+					}
+				}
+			}
+			if (Tilt_IsOn())
+			{
+				summarised = bTRUE;
+				for (uint16_t i = 0; i < filtered; i++)
+				{
+					TTilt tilt;
+					Tilt_Add(&PipelineOutput[i], &tilt);
+					(void) CMD_SendTilt(&tilt);
+				}
+			}
+			if (!summarised && filtered)
+			{
+				(void) CMD_SendAccelerometerValues(PipelineOutput, (uint8_t) filtered);
+			}
+		}
+		Samples_Release(&AccRing, count);
 	}
+}
 
-	//Shift history
-	ShiftArray(AccelXHistory, 3, AccReadData[0]);
-	ShiftArray(AccelYHistory, 3, AccReadData[1]);
-	ShiftArray(AccelZHistory, 3, AccReadData[2]);
-
-	uint8_t xMed = Median_Filter3(AccelXHistory[0], AccelXHistory[1], AccelXHistory[2]);
-	uint8_t yMed = Median_Filter3(AccelYHistory[0], AccelYHistory[1], AccelYHistory[2]);
-	uint8_t zMed = Median_Filter3(AccelZHistory[0], AccelZHistory[1], AccelZHistory[2]);
-
-	if ((xMed != AccelSendHistory[0]) | (yMed != AccelSendHistory[1]) | (zMed != AccelSendHistory[2]))
+/*!
+ * @brief Run on the main thread to handle new accelerometer events.
+ */
+static void HandleNewAccelEvents()
+{
+	//A sleep or wake switch alone reads no events
+	if (AccEvents.count)
 	{
-		AccelSendHistory[0] = xMed;
-		AccelSendHistory[1] = yMed;
-		AccelSendHistory[2] = zMed;
-		(void) CMD_SendAccelerometerValues(AccelSendHistory);
+		(void) CMD_SendAccelerometerEvents(&AccEvents);
 	}
 }
 
 /*!
- * @brief FTM Timer run after a packet arrives.
+ * @brief Time the blue LED stays on after a packet arrives, in ms.
  */
-const static TTimer PacketTimer = { TC_PACKETTIMER,
-		24414,
-		TIMER_FUNCTION_OUTPUT_COMPARE,
-		TIMER_OUTPUT_DISCONNECT,
+#define PACKET_LED_TIME 1000
+
+/*!
+ * @brief Timer run after a packet arrives.
+ */
+static TWheelTimer PacketTimer = { NULL,
+		NULL,
+		0,
+		0,
 		&BlueOff,
 		(void *) 0 };
 
 /*!
- * @brief Asserted if the "AccTimer" is running.
+ * @brief Sample period the "AccTimer" is running at, 0 when it is stopped.
  */
-static uint8_t AccTimerRunningFlag = 0;
+static uint32_t AccTimerPeriod = 0;
 
 /*!
- * @brief Called when the 1Hz timer expires, or when the
+ * @brief Called when the poll timer expires, or when the
  *        accelerometer ISR fires.
  */
 void AccTimerCallback(void *arguments)
 {
-	AccTimerRunningFlag = 0;
 	QueueAccelRead((void *) 0);
 }
 
 /*!
- * @brief Timer to run the 1Hz accelerometer polling.
+ * @brief Periodic timer to run the accelerometer polling, the count follows the output data rate.
  */
-const static TTimer AccTimer = { TC_ACCTIMER,
-		48828,
+static TTimer AccTimer = { TC_ACCTIMER,
+		0,
 		TIMER_FUNCTION_OUTPUT_COMPARE,
 		TIMER_OUTPUT_DISCONNECT,
 		&AccTimerCallback,
-		(void *) 0 };
+		(void *) 0,
+		0 };
+
+/*!
+ * @brief FTM counts in one sample period of the accelerometer.
+ * @return The count, limited to what fits in the 16-bit counter.
+ */
+static uint16_t AccTimerCount()
+{
+	uint64_t count = ((uint64_t) Accel_GetSamplePeriod() * CPU_MCGFF_CLK_HZ_CONFIG_0 + 500000) / 1000000;
+	if (count == 0)
+	{
+		return 1;
+	}
+	return (count > 0xFFFF) ? 0xFFFF : (uint16_t) count;
+}
 
 /*!
  * @brief Accelerometer module setup structure.
@@ -224,7 +432,7 @@ const static TAccelSetup AccelSetup = { CPU_BUS_CLK_HZ,
 		&AccTimerCallback,
 		(void *) 0,
 		&AccelReadCallback,
-		AccReadData };
+		&AccSample };
 
 /*!
  * @brief Handle incoming packets
@@ -259,6 +467,65 @@ void HandlePacket()
 		break;
 	case CMD_RX_PROTOCOL_MODE:
 		error = !CMD_ProtocolMode(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		//The main thread starts or stops the poll timer to suit the mode
+		(void) OS_SemaphoreSignal(AccelSemaphore);
+		break;
+	case CMD_RX_ACCEL_RESOLUTION:
+		error = !CMD_AccelResolution(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_DATA_RATE:
+		error = !CMD_AccelDataRate(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_RANGE:
+		error = !CMD_AccelRange(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_OVERSAMPLING:
+		error = !CMD_AccelOversampling(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_EVENTS:
+		error = !CMD_AccelEvents(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_AUTO_SLEEP:
+		error = !CMD_AccelAutoSleep(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_ACQUISITION:
+		error = !CMD_AccelAcquisition(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_MEDIAN_WINDOW:
+		error = !CMD_AccelMedianWindow(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_PIPELINE:
+		error = !CMD_AccelPipeline(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_SPECTRUM:
+		error = !CMD_AccelSpectrum(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_DEADBAND:
+		error = !CMD_AccelDeadband(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_HEARTBEAT:
+		error = !CMD_AccelHeartbeat(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_SUMMARY_WINDOW:
+		error = !CMD_AccelSummaryWindow(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_ACCEL_TILT:
+		error = !CMD_AccelTilt(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_UPDATE_BEGIN:
+		error = !CMD_UpdateBegin(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_UPDATE_DATA:
+		error = !CMD_UpdateData(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_UPDATE_CRC:
+		error = !CMD_UpdateCRC(Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
+		break;
+	case CMD_RX_UPDATE_COMMIT:
+		error = !CMD_UpdateCommit();
+		break;
+	case CMD_RX_BENCHMARK:
+		error = !CMD_Benchmark(Packet_Parameter1);
 		break;
 	default:
 		break;
@@ -277,6 +544,12 @@ void HandlePacket()
 		}
 		Packet_Put(maskedPacket, Packet_Parameter1, Packet_Parameter2, Packet_Parameter3);
 	}
+
+	//The new firmware takes over once the acknowledgement is out
+	if (Update_IsComplete())
+	{
+		Update_Reset();
+	}
 }
 /*!
  * @brief Semaphore to wait on for the RTC.
@@ -350,7 +623,7 @@ void PacketThread(void *data)
 
 		OS_SemaphoreWait(Packet_Semaphore, 0);
 		LEDs_On(LED_BLUE);
-		Timer_Start(&PacketTimer);
+		(void) Wheel_Start(&PacketTimer, PACKET_LED_TIME, 0);
 		HandlePacket();
 
 		/*
@@ -382,7 +655,8 @@ void MainThread(void *data)
 {
 	for (;;)
 	{
-		OS_TimeDelay(10);
+		//Only runs when the timer, the accelerometer, the I2C or a mode change has something for us
+		OS_SemaphoreWait(AccelSemaphore, 0);
 		/*
 		 * If there is a new packet available,
 		 *  turn on the blue LED, start the timer
@@ -396,35 +670,46 @@ void MainThread(void *data)
 //      HandlePacket();
 //    }
 		/*
-		 * If the accelerometer 1Hz timer is *NOT* running and
-		 *  we are in poll mode, resta rt the timer.
-		 * Also reset the flag.
+		 * The accelerometer poll timer reloads itself,
+		 *  it only needs starting when we go into poll mode
+		 *  or the sample period changes, and stopping when we leave.
 		 */
-		if (!AccTimerRunningFlag && (Accel_GetMode() == ACCEL_POLL))
+		uint32_t period = (Accel_GetMode() == ACCEL_POLL) ? Accel_GetSamplePeriod() : 0;
+		if (period != AccTimerPeriod)
 		{
-			AccTimerRunningFlag = 1;
-			Timer_Start(&AccTimer);
+			AccTimerPeriod = period;
+			if (period)
+			{
+				AccTimer.initialCount = AccTimerCount();
+				AccTimer.period = AccTimer.initialCount;
+				(void) Timer_Start(&AccTimer);
+			}
+			else
+			{
+				(void) Timer_Stop(&AccTimer);
+			}
 		}
 
 		/*
 		 * If there is a pending accelerometer read,
-		 *  read the XYZ values from the accelerometer
+		 *  queue it for the current mode
 		 *  and clear the flag.
 		 */
 		if (PendingAccelReadFlag)
 		{
 			PendingAccelReadFlag = 0;
-			Accel_ReadXYZ(AccReadData);
+			StartAccelRead();
 		}
 
 		/*
-		 * If there is accelerometer data available,
-		 *  clear the flag and handle the data.
+		 * Send whatever accelerometer samples have arrived,
+		 *  and the events if there are new ones.
 		 */
-		if (NewAccelDataFlag)
+		HandleNewAccelData();
+		if (NewAccelEventsFlag)
 		{
-			NewAccelDataFlag = 0;
-			HandleNewAccelData();
+			NewAccelEventsFlag = 0;
+			HandleNewAccelEvents();
 		}
 	}
 }
@@ -572,8 +857,16 @@ void InitThread(void *data)
 //Initialize all the modules
 		LEDs_Init();
 
+		Samples_Init(&AccRing);
 		I2C_Init(100000, MODULE_CLOCK);
 		Accel_Init(&AccelSetup);
+		(void) Filter_Init();
+		(void) History_Init(&AccelSendHistory, AccelSendSamples, ACCEL_SEND_HISTORY_SIZE);
+		(void) Report_Init();
+		(void) Dsp_Init();
+		(void) Spectrum_Init();
+		(void) Summary_Init();
+		(void) Tilt_Init();
 
 		PIT_Init(MODULE_CLOCK, &PitCallback, (void *) 0);
 		PIT_Set(500000000, bFALSE);
@@ -581,18 +874,23 @@ void InitThread(void *data)
 
 		Packet_Init(BAUD_RATE, MODULE_CLOCK);
 		Flash_Init();
+		Update_Init();
 		CMD_Init();
+		Bench_Init();
 
 		//Best to do this one last
 		//TODO: disabled for yellow
     RTC_Init((void (*)(void*))OS_SemaphoreSignal, (void *) RtcSemaphore);
 
 		Timer_Init();
-		Timer_Set(&PacketTimer);
+		(void) Wheel_Init(TC_WHEEL);
 		Timer_Set(&AccTimer);
 
 		CMD_SpecialGetStartupValues();
 
+		//Everything is set up, let the main thread start the poll timer
+		(void) OS_SemaphoreSignal(AccelSemaphore);
+
 		LEDs_On(LED_ORANGE);
 	}
 }
@@ -617,6 +915,7 @@ int main(void)
 	EventSemaphore = OS_SemaphoreCreate(0);
 	InitSemaphore = OS_SemaphoreCreate(1);
 	RtcSemaphore = OS_SemaphoreCreate(0);
+	AccelSemaphore = OS_SemaphoreCreate(0);
 
 	//Make some threads.
 	CREATE_THREAD(InitThread, NULL, InitThreadStack, TP_INITTHREAD);
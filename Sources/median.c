@@ -2,7 +2,8 @@
  *
  *  @brief Median filter.
  *
- *  This contains the functions for performing a median filter on byte-sized data.
+ *  This contains the functions for performing a median filter on byte-sized and 16-bit signed data,
+ *  and a streaming median filter over a sliding window of samples.
  *
  *  @author Robin Wohlers-Reichel, Joshua Gonsalves
  *  @date 2015-10-12
@@ -21,6 +22,252 @@ uint8_t Median_Filter3(const uint8_t n1, const uint8_t n2, const uint8_t n3)
 {
 	return MAX(MIN(n1, n2), MIN(MAX(n1, n2), n3));
 }
+
+int16_t Median_Filter3Int16(const int16_t n1, const int16_t n2, const int16_t n3)
+{
+	return MAX(MIN(n1, n2), MIN(MAX(n1, n2), n3));
+}
+
+/*!
+ * @brief The smaller of each signed halfword.
+ * @param a The first pair.
+ * @param b The second pair.
+ * @return The minimums, packed.
+ */
+static inline uint32_t MinPacked(const uint32_t a, const uint32_t b)
+{
+#if defined(__arm__)
+	uint32_t result;
+	//GE flags are set for each half where a >= b, SEL takes b there
+	__asm ("SSUB16 %0, %1, %2\n\tSEL %0, %2, %1" : "=&r" (result) : "r" (a), "r" (b) : "cc");
+	return result;
+#else
+	//The host benchmark
+	return (uint16_t) MIN((int16_t) a, (int16_t) b) | ((uint32_t) (uint16_t) MIN((int16_t) (a >> 16), (int16_t) (b >> 16)) << 16);
+#endif
+}
+
+/*!
+ * @brief The larger of each signed halfword.
+ * @param a The first pair.
+ * @param b The second pair.
+ * @return The maximums, packed.
+ */
+static inline uint32_t MaxPacked(const uint32_t a, const uint32_t b)
+{
+#if defined(__arm__)
+	uint32_t result;
+	__asm ("SSUB16 %0, %1, %2\n\tSEL %0, %1, %2" : "=&r" (result) : "r" (a), "r" (b) : "cc");
+	return result;
+#else
+	return (uint16_t) MAX((int16_t) a, (int16_t) b) | ((uint32_t) (uint16_t) MAX((int16_t) (a >> 16), (int16_t) (b >> 16)) << 16);
+#endif
+}
+
+uint32_t Median_Filter3Packed(const uint32_t n1, const uint32_t n2, const uint32_t n3)
+{
+	return MaxPacked(MinPacked(n1, n2), MinPacked(MaxPacked(n1, n2), n3));
+}
+
+/*!
+ * @brief The value index at a heap position, positions run from -(window / 2) to (window - 1) / 2.
+ */
+#define HEAP(filter, i) ((filter)->heap[(MEDIAN_WINDOW_MAX / 2) + (i)])
+
+/*!
+ * @brief The value at a heap position.
+ */
+#define HEAP_VALUE(filter, i) ((filter)->values[HEAP(filter, i)])
+
+/*!
+ * @brief Swap the values at two heap positions if the one at i is less than the one at j.
+ * @param filter The filter.
+ * @param i The first position.
+ * @param j The second position.
+ * @return bTRUE if they were swapped.
+ */
+static BOOL SwapIfLess(TMedianFilter * const filter, const int8_t i, const int8_t j)
+{
+	if (HEAP_VALUE(filter, i) >= HEAP_VALUE(filter, j))
+	{
+		return bFALSE;
+	}
+	uint8_t index = HEAP(filter, i);
+	HEAP(filter, i) = HEAP(filter, j);
+	HEAP(filter, j) = index;
+	filter->position[HEAP(filter, i)] = i;
+	filter->position[HEAP(filter, j)] = j;
+	return bTRUE;
+}
+
+/*!
+ * @brief Move the value at position i down the min heap until its children are larger.
+ * @param filter The filter.
+ * @param i The position, at least 1.
+ */
+static void MinSortDown(TMedianFilter * const filter, int8_t i)
+{
+	for (i *= 2; i <= filter->minCount; i *= 2)
+	{
+		//The smaller child
+		if ((i < filter->minCount) && (HEAP_VALUE(filter, i + 1) < HEAP_VALUE(filter, i)))
+		{
+			i++;
+		}
+		if (!SwapIfLess(filter, i, i / 2))
+		{
+			break;
+		}
+	}
+}
+
+/*!
+ * @brief Move the value at position i down the max heap until its children are smaller.
+ * @param filter The filter.
+ * @param i The position, at most -1.
+ */
+static void MaxSortDown(TMedianFilter * const filter, int8_t i)
+{
+	for (i *= 2; i >= -filter->maxCount; i *= 2)
+	{
+		//The larger child
+		if ((i > -filter->maxCount) && (HEAP_VALUE(filter, i) < HEAP_VALUE(filter, i - 1)))
+		{
+			i--;
+		}
+		if (!SwapIfLess(filter, i / 2, i))
+		{
+			break;
+		}
+	}
+}
+
+/*!
+ * @brief Move the value at position i up the min heap, as far as the median.
+ * @param filter The filter.
+ * @param i The position, at least 1.
+ * @return bTRUE if it became the median.
+ */
+static BOOL MinSortUp(TMedianFilter * const filter, int8_t i)
+{
+	while ((i > 0) && SwapIfLess(filter, i, i / 2))
+	{
+		i /= 2;
+	}
+	return (i == 0);
+}
+
+/*!
+ * @brief Move the value at position i up the max heap, as far as the median.
+ * @param filter The filter.
+ * @param i The position, at most -1.
+ * @return bTRUE if it became the median.
+ */
+static BOOL MaxSortUp(TMedianFilter * const filter, int8_t i)
+{
+	//Division rounds towards zero, so the parent of -2 and -3 is -1
+	while ((i < 0) && SwapIfLess(filter, i / 2, i))
+	{
+		i /= 2;
+	}
+	return (i == 0);
+}
+
+BOOL Median_Init(TMedianFilter * const filter, const uint8_t window)
+{
+	if ((window < MEDIAN_WINDOW_MIN) || (window > MEDIAN_WINDOW_MAX))
+	{
+		return bFALSE;
+	}
+	filter->window = window;
+	filter->next = 0;
+	filter->minCount = 0;
+	filter->maxCount = 0;
+
+	//The values fill the median, then alternately the max and min heaps: 0, -1, 1, -2, 2...
+	for (uint8_t i = 0; i < window; i++)
+	{
+		int8_t position = (int8_t) ((i + 1) / 2);
+		filter->position[i] = (i & 1) ? -position : position;
+		HEAP(filter, filter->position[i]) = i;
+		filter->values[i] = 0;
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Restore the heaps after the value at a position has been replaced.
+ * @param filter The filter.
+ * @param p The position.
+ * @param value The new value.
+ * @param old The value it replaced.
+ */
+static void Reheap(TMedianFilter * const filter, const int8_t p, const int16_t value, const int16_t old)
+{
+	if (p > 0)
+	{
+		//In the min heap, a larger value only needs to move down
+		if (filter->minCount < (filter->window - 1) / 2)
+		{
+			filter->minCount++;
+		}
+		else if (value > old)
+		{
+			MinSortDown(filter, p);
+			return;
+		}
+		if (MinSortUp(filter, p) && SwapIfLess(filter, 0, -1))
+		{
+			MaxSortDown(filter, -1);
+		}
+	}
+	else if (p < 0)
+	{
+		//In the max heap, a smaller value only needs to move down
+		if (filter->maxCount < filter->window / 2)
+		{
+			filter->maxCount++;
+		}
+		else if (value < old)
+		{
+			MaxSortDown(filter, p);
+			return;
+		}
+		if (MaxSortUp(filter, p) && filter->minCount && SwapIfLess(filter, 1, 0))
+		{
+			MinSortDown(filter, 1);
+		}
+	}
+	else
+	{
+		//The median itself, it can move into either heap
+		if (filter->maxCount && MaxSortUp(filter, -1))
+		{
+			MaxSortDown(filter, -1);
+		}
+		if (filter->minCount && MinSortUp(filter, 1))
+		{
+			MinSortDown(filter, 1);
+		}
+	}
+}
+
+int16_t Median_Update(TMedianFilter * const filter, const int16_t value)
+{
+	int8_t p = filter->position[filter->next];
+	int16_t old = filter->values[filter->next];
+	filter->values[filter->next] = value;
+	filter->next = (filter->next + 1 == filter->window) ? 0 : filter->next + 1;
+
+	Reheap(filter, p, value, old);
+
+	//Fewer in the min heap only while an even number have been added
+	if (filter->minCount < filter->maxCount)
+	{
+		return (int16_t) (((int32_t) HEAP_VALUE(filter, 0) + HEAP_VALUE(filter, -1)) / 2);
+	}
+	return HEAP_VALUE(filter, 0);
+}
 /*!
 ** @}
 */
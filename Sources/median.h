@@ -2,7 +2,8 @@
  *
  *  @brief Median filter.
  *
- *  This contains the functions for performing a median filter on byte-sized data.
+ *  This contains the functions for performing a median filter on byte-sized and 16-bit signed data,
+ *  and a streaming median filter over a sliding window of samples.
  *
  *  @author PMcL
  *  @date 2015-10-12
@@ -17,6 +18,34 @@
 // New types
 #include "types.h"
 
+/*!
+ * @brief Smallest window of a streaming median filter.
+ */
+#define MEDIAN_WINDOW_MIN 3
+
+/*!
+ * @brief Largest window of a streaming median filter.
+ */
+#define MEDIAN_WINDOW_MAX 63
+
+/*!
+ * @brief A streaming median filter.
+ *
+ * The window is a ring of values, each held in one of two heaps around the median:
+ * a max heap of the smaller half below it and a min heap of the larger half above it.
+ * Replacing the oldest value moves it through one heap, O(log window).
+ */
+typedef struct
+{
+  int16_t values[MEDIAN_WINDOW_MAX];    /*!< The window, a ring indexed by next. */
+  int8_t position[MEDIAN_WINDOW_MAX];   /*!< Heap position of each value, negative in the max heap, 0 the median. */
+  uint8_t heap[MEDIAN_WINDOW_MAX];      /*!< Index of the value at each heap position, offset by MEDIAN_WINDOW_MAX / 2. */
+  uint8_t window;                       /*!< Number of values in the window. */
+  uint8_t next;                         /*!< The value replaced by the next update. */
+  uint8_t minCount;                     /*!< Number of values in the min heap. */
+  uint8_t maxCount;                     /*!< Number of values in the max heap. */
+} TMedianFilter;
+
 /*! @brief Median filters 3 bytes.
  *
  *  @param n1 is the first  of 3 bytes for which the median is sought.
@@ -26,6 +55,57 @@
  */
 uint8_t Median_Filter3(const uint8_t n1, const uint8_t n2, const uint8_t n3);
 
+/*! @brief Median filters 3 signed 16-bit values.
+ *
+ *  @param n1 is the first  of 3 values for which the median is sought.
+ *  @param n2 is the second of 3 values for which the median is sought.
+ *  @param n3 is the third  of 3 values for which the median is sought.
+ *  @return int16_t The value.
+ */
+int16_t Median_Filter3Int16(const int16_t n1, const int16_t n2, const int16_t n3);
+
+/*!
+ * @brief Pack two signed 16-bit values for Median_Filter3Packed.
+ */
+#define MEDIAN_PACK(low, high) ((uint32_t) (uint16_t) (low) | ((uint32_t) (uint16_t) (high) << 16))
+
+/*!
+ * @brief The low value of a packed word.
+ */
+#define MEDIAN_UNPACK_LOW(packed) ((int16_t) ((packed) & 0xFFFF))
+
+/*!
+ * @brief The high value of a packed word.
+ */
+#define MEDIAN_UNPACK_HIGH(packed) ((int16_t) ((packed) >> 16))
+
+/*! @brief Median filters 3 words of two packed signed 16-bit values, both halves at once.
+ *
+ *  Uses the DSP instructions SSUB16 and SEL, with no branches.
+ *  @param n1 is the first  of 3 words for which the medians are sought.
+ *  @param n2 is the second of 3 words for which the medians are sought.
+ *  @param n3 is the third  of 3 words for which the medians are sought.
+ *  @return uint32_t The median of the low halves and of the high halves, packed.
+ */
+uint32_t Median_Filter3Packed(const uint32_t n1, const uint32_t n2, const uint32_t n3);
+
+/*! @brief Sets up a streaming median filter with no values in it.
+ *
+ *  @param filter is the filter.
+ *  @param window is the number of values the median is taken over, MEDIAN_WINDOW_MIN to MEDIAN_WINDOW_MAX.
+ *  @return BOOL - TRUE if the window is valid.
+ */
+BOOL Median_Init(TMedianFilter * const filter, const uint8_t window);
+
+/*! @brief Adds a value to a streaming median filter, replacing the oldest once the window is full.
+ *
+ *  @param filter is the filter.
+ *  @param value is the new value.
+ *  @return int16_t The median of the values in the window,
+ *          the mean of the middle two while an even number have been added.
+ */
+int16_t Median_Update(TMedianFilter * const filter, const int16_t value);
+
 #endif
 /*!
 ** @}
@@ -0,0 +1,34 @@
+/*! @file
+ *
+ *  @brief Placement of routines in RAM.
+ *
+ *  Routines marked with RAMFUNC are linked into the ".ramfunc" section, which the
+ *  startup code copies into SRAM along with ".data". They can keep executing while
+ *  the FTFE is erasing or programming the block they would otherwise be fetched from.
+ *  Interrupt handlers stay in Flash: the one command on the active block runs with
+ *  interrupts disabled, every other command is on the inactive block, which the active
+ *  block can be read alongside.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-04
+ */
+/*!
+**  @addtogroup ramfunc_module RAM function module documentation
+**  @{
+*/
+#ifndef RAMFUNC_H
+#define RAMFUNC_H
+
+/*!
+ * @brief Places a function in RAM.
+ *
+ * SRAM_L (0x1FFF0000) is out of BL range of the Flash, the linker inserts veneers for these calls.
+ * noinline stops the body from being copied back into a Flash resident caller.
+ */
+#define RAMFUNC __attribute__ ((section(".ramfunc"), noinline))
+
+#endif
+
+/*!
+** @}
+*/
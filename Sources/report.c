@@ -0,0 +1,127 @@
+/*! @file
+ *
+ *  @brief Implementation of the sample reporting decision.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-17
+ */
+/*!
+**  @addtogroup report_module Report module documentation
+**  @{
+*/
+#include "report.h"
+
+#include "Cpu.h"
+
+/*!
+ * @brief Dead-band of each axis.
+ */
+static volatile uint8_t Deadbands[3];
+
+/*!
+ * @brief Asserted for each axis which moved past its threshold at the last sample.
+ */
+static BOOL Moving[3];
+
+/*!
+ * @brief Heartbeat interval in ms, 0 when off.
+ */
+static volatile uint16_t Heartbeat;
+
+/*!
+ * @brief Time since a sample was last sent, in us.
+ */
+static uint32_t Silence;
+
+/*!
+ * @brief Counts for Report_GetStatistics.
+ */
+static TReportStatistics Statistics;
+
+BOOL Report_Init()
+{
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		Deadbands[axis] = REPORT_DEFAULT_DEADBAND;
+		Moving[axis] = bFALSE;
+	}
+	Heartbeat = 0;
+	Silence = 0;
+	return bTRUE;
+}
+
+BOOL Report_SetDeadband(const uint8_t axis, const uint8_t deadband)
+{
+	if (axis > ACCEL_Z)
+	{
+		return bFALSE;
+	}
+	Deadbands[axis] = deadband;
+	return bTRUE;
+}
+
+uint8_t Report_GetDeadband(const uint8_t axis)
+{
+	return (axis > ACCEL_Z) ? 0 : Deadbands[axis];
+}
+
+void Report_SetHeartbeat(const uint16_t interval)
+{
+	Heartbeat = interval;
+}
+
+uint16_t Report_GetHeartbeat()
+{
+	return Heartbeat;
+}
+
+BOOL Report_Check(const TAccelSample * const sample, const TAccelSample * const sent)
+{
+	BOOL send = bFALSE;
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		int32_t change = (int32_t) sample->axes[axis] - sent->axes[axis];
+		if (change < 0)
+		{
+			change = -change;
+		}
+		//Half the dead-band while moving, the axis settles once it changes by less than that
+		int32_t threshold = Moving[axis] ? (Deadbands[axis] >> 1) : Deadbands[axis];
+		Moving[axis] = (change > threshold) ? bTRUE : bFALSE;
+		send |= Moving[axis];
+	}
+
+	Silence += Accel_GetSamplePeriod();
+	BOOL heartbeat = !send && Heartbeat && (Silence >= (uint32_t) Heartbeat * 1000);
+	if (send || heartbeat)
+	{
+		Silence = 0;
+	}
+
+	EnterCritical();
+	Statistics.samples++;
+	if (send || heartbeat)
+	{
+		Statistics.sent++;
+	}
+	if (heartbeat)
+	{
+		Statistics.heartbeats++;
+	}
+	ExitCritical();
+	return (send || heartbeat);
+}
+
+void Report_GetStatistics(TReportStatistics * const statistics)
+{
+	EnterCritical();
+	*statistics = Statistics;
+	Statistics.samples = 0;
+	Statistics.sent = 0;
+	Statistics.heartbeats = 0;
+	ExitCritical();
+}
+
+/*!
+** @}
+*/
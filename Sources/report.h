@@ -0,0 +1,92 @@
+/*! @file
+ *
+ *  @brief Decides which filtered accelerometer samples are worth sending.
+ *
+ *  A sample is sent when an axis has moved further than its dead-band from the last one sent.
+ *  Once an axis is moving it only needs to move half as far, until a sample within that,
+ *  so a slow change isn't sent in dead-band sized steps and noise at rest isn't sent at all.
+ *  A heartbeat sends the sample anyway after a set time without one.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-17
+ */
+/*!
+**  @addtogroup report_module Report module documentation
+**  @{
+*/
+#ifndef REPORT_H
+#define REPORT_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Dead-band used until Report_SetDeadband is called, any change is sent.
+ */
+#define REPORT_DEFAULT_DEADBAND 0
+
+/*!
+ * @brief How the samples were reported.
+ */
+typedef struct
+{
+  uint32_t samples;       /*!< Samples checked. */
+  uint32_t sent;          /*!< Samples sent, including the heartbeats. */
+  uint32_t heartbeats;    /*!< Samples sent only for the heartbeat. */
+} TReportStatistics;
+
+/*! @brief Sets up the default dead-bands with the heartbeat off.
+ *
+ *  @return BOOL - TRUE if the module was successfully initialized.
+ */
+BOOL Report_Init();
+
+/*! @brief Sets the dead-band of an axis.
+ *
+ *  @param axis ACCEL_X, ACCEL_Y or ACCEL_Z.
+ *  @param deadband The change needed to send a sample, in 14-bit counts.
+ *  @return BOOL - TRUE if the axis is valid.
+ */
+BOOL Report_SetDeadband(const uint8_t axis, const uint8_t deadband);
+
+/*!
+ * @brief Gets the dead-band of an axis.
+ * @param axis ACCEL_X, ACCEL_Y or ACCEL_Z.
+ * @return uint8_t
+ */
+uint8_t Report_GetDeadband(const uint8_t axis);
+
+/*! @brief Sets the longest time without sending a sample.
+ *
+ *  @param interval The time in ms, 0 for no heartbeat.
+ */
+void Report_SetHeartbeat(const uint16_t interval);
+
+/*!
+ * @brief Gets the longest time without sending a sample.
+ * @return uint16_t The time in ms, 0 for no heartbeat.
+ */
+uint16_t Report_GetHeartbeat();
+
+/*! @brief Checks whether a sample should be sent.
+ *
+ *  Called once per sample period.
+ *  @param sample The filtered sample.
+ *  @param sent The last sample sent.
+ *  @return BOOL - TRUE if the sample should be sent.
+ */
+BOOL Report_Check(const TAccelSample * const sample, const TAccelSample * const sent);
+
+/*! @brief Reads and clears the counts of samples checked and sent.
+ *
+ *  @param statistics is filled with the counts since the last call.
+ */
+void Report_GetStatistics(TReportStatistics * const statistics);
+
+#endif
+
+/*!
+** @}
+*/
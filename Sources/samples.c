@@ -0,0 +1,107 @@
+/*! @file
+ *
+ *  @brief Implementation of the lock-free ring of timestamped accelerometer samples.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-12
+ */
+/*!
+**  @addtogroup samples_module Samples module documentation
+**  @{
+*/
+#include "samples.h"
+
+#include "bench.h"
+
+#include "Cpu.h"
+
+/*!
+ * @brief Mask a free running count into an index.
+ */
+#define SAMPLES_INDEX(count) ((count) & (SAMPLES_RING_SIZE - 1))
+
+/*!
+ * @brief Keep the sample accesses on the right side of the index update.
+ */
+#define SAMPLES_BARRIER() __asm volatile ("DMB" ::: "memory")
+
+/*!
+ * @brief Latency measurements, for Samples_GetLatency.
+ */
+static TSampleLatency Latency = { 0, UINT32_MAX, 0, 0 };
+
+void Samples_Init(TSampleRing * const ring)
+{
+	ring->Head = 0;
+	ring->Tail = 0;
+	ring->Dropped = 0;
+}
+
+BOOL Samples_Put(TSampleRing * const ring, const TAccelSample * const sample, const uint32_t time)
+{
+	uint16_t head = ring->Head;
+	if ((uint16_t) (head - ring->Tail) >= SAMPLES_RING_SIZE)
+	{
+		ring->Dropped++;
+		return bFALSE;
+	}
+	ring->Samples[SAMPLES_INDEX(head)] = *sample;
+	ring->Times[SAMPLES_INDEX(head)] = time;
+	//The sample has to be in place before the consumer can see it
+	SAMPLES_BARRIER();
+	ring->Head = head + 1;
+	return bTRUE;
+}
+
+uint16_t Samples_Peek(TSampleRing * const ring, const TAccelSample ** const samples, const uint32_t ** const times)
+{
+	uint16_t tail = ring->Tail;
+	uint16_t count = ring->Head - tail;
+	//Don't read the samples before the count which covers them
+	SAMPLES_BARRIER();
+
+	uint16_t toEnd = SAMPLES_RING_SIZE - SAMPLES_INDEX(tail);
+	if (count > toEnd)
+	{
+		count = toEnd;
+	}
+	*samples = &ring->Samples[SAMPLES_INDEX(tail)];
+	*times = &ring->Times[SAMPLES_INDEX(tail)];
+	return count;
+}
+
+void Samples_Release(TSampleRing * const ring, const uint16_t count)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	uint16_t tail = ring->Tail;
+	uint32_t latency = BENCH_CYCLES() - ring->Times[SAMPLES_INDEX(tail + count - 1)];
+
+	//Finish with the samples before the producer can reuse them
+	SAMPLES_BARRIER();
+	ring->Tail = tail + count;
+
+	EnterCritical();
+	Latency.count++;
+	Latency.total += latency;
+	Latency.min = (latency < Latency.min) ? latency : Latency.min;
+	Latency.max = (latency > Latency.max) ? latency : Latency.max;
+	ExitCritical();
+}
+
+void Samples_GetLatency(TSampleLatency * const latency)
+{
+	EnterCritical();
+	*latency = Latency;
+	Latency.count = 0;
+	Latency.min = UINT32_MAX;
+	Latency.max = 0;
+	Latency.total = 0;
+	ExitCritical();
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,99 @@
+/*! @file
+ *
+ *  @brief Lock-free ring of timestamped accelerometer samples.
+ *
+ *  One producer (the accelerometer read complete callback, in the I2C ISR)
+ *  hands samples to one consumer (a thread) without disabling interrupts.
+ *  The producer only writes Head and the consumer only writes Tail,
+ *  so a sample is never seen before it is complete, nor overwritten before it is released.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-12
+ */
+/*!
+**  @addtogroup samples_module Samples module documentation
+**  @{
+*/
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Number of samples in a ring, a power of 2.
+ *        Holds 4 full FIFO bursts, or 160 ms at 800 Hz.
+ */
+#define SAMPLES_RING_SIZE 128
+
+/*!
+ * @struct TSampleRing
+ */
+typedef struct
+{
+  uint16_t volatile Head;     /*!< Free running count of samples put, only written by the producer. */
+  uint16_t volatile Tail;     /*!< Free running count of samples released, only written by the consumer. */
+  uint32_t Dropped;           /*!< Samples the producer dropped because the ring was full. */
+  uint32_t Times[SAMPLES_RING_SIZE];          /*!< Cycle counter when each sample was read. */
+  TAccelSample Samples[SAMPLES_RING_SIZE];    /*!< The samples. */
+} TSampleRing;
+
+/*!
+ * @brief Time from the read being triggered to the samples being released.
+ */
+typedef struct
+{
+  uint32_t count;     /*!< Number of releases measured. */
+  uint32_t min;       /*!< Shortest, in cycles. */
+  uint32_t max;       /*!< Longest, in cycles. */
+  uint32_t total;     /*!< Sum of all of them, in cycles. */
+} TSampleLatency;
+
+/*! @brief Initialize the ring before first use.
+ *
+ *  @param ring A pointer to the ring that needs initializing.
+ */
+void Samples_Init(TSampleRing * const ring);
+
+/*! @brief Add a sample, called by the producer.
+ *
+ *  @param ring A pointer to the ring.
+ *  @param sample The sample, copied into the ring.
+ *  @param time The cycle counter when the read of the sample was triggered.
+ *  @return BOOL - TRUE if the sample was added, FALSE (and Dropped counted) if the ring is full.
+ */
+BOOL Samples_Put(TSampleRing * const ring, const TAccelSample * const sample, const uint32_t time);
+
+/*! @brief Get the oldest unreleased samples, called by the consumer.
+ *
+ *  The samples stay in the ring until released. Only the run up to the end
+ *  of the buffer is returned, so after a wrap a second call returns the rest.
+ *  @param ring A pointer to the ring.
+ *  @param samples Set to the first sample.
+ *  @param times Set to the time of the first sample.
+ *  @return uint16_t - The number of contiguous samples available.
+ */
+uint16_t Samples_Peek(TSampleRing * const ring, const TAccelSample ** const samples, const uint32_t ** const times);
+
+/*! @brief Hand samples back to the producer, called by the consumer.
+ *
+ *  The consumer should be done with the samples (sent or filtered),
+ *  the latency of the newest one is measured against its time.
+ *  @param ring A pointer to the ring.
+ *  @param count The number of samples, at most what Samples_Peek returned.
+ */
+void Samples_Release(TSampleRing * const ring, const uint16_t count);
+
+/*! @brief Reads and clears the latency measurements of all rings.
+ *
+ *  @param latency is filled with the measurements since the last call.
+ */
+void Samples_GetLatency(TSampleLatency * const latency);
+
+#endif
+
+/*!
+** @}
+*/
@@ -0,0 +1,178 @@
+/*! @file
+ *
+ *  @brief Implementation of the spectrum analysis.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-15
+ */
+/*!
+**  @addtogroup spectrum_module Spectrum module documentation
+**  @{
+*/
+#include "spectrum.h"
+
+#include "fft.h"
+
+/*!
+ * @brief Shift of the 14-bit samples in the window, so they use all 16 bits.
+ *
+ * Filtered samples can overshoot 14 bits, the window saturates them.
+ */
+#define SAMPLE_SHIFT 2
+
+/*!
+ * @brief Frame size as set by Spectrum_Set, 0 when off.
+ */
+static volatile uint16_t Size = 0;
+
+/*!
+ * @brief Axis as set by Spectrum_Set.
+ */
+static volatile uint8_t Axis = ACCEL_X;
+
+/*!
+ * @brief Asserted when the settings have changed and the frame needs clearing.
+ */
+static volatile BOOL SettingsChanged;
+
+/*!
+ * @brief Frame size being collected, only touched by Spectrum_Add.
+ */
+static uint16_t FrameSize;
+
+/*!
+ * @brief Axis being collected.
+ */
+static uint8_t FrameAxis;
+
+/*!
+ * @brief The last FrameSize samples of the axis, a ring as FrameSize is a power of 2.
+ */
+static int16_t FrameSamples[FFT_SIZE_MAX];
+
+/*!
+ * @brief Where the next sample goes in FrameSamples, the oldest once the frame is full.
+ */
+static uint16_t FrameNext;
+
+/*!
+ * @brief Samples until the next frame is analysed.
+ */
+static uint16_t FrameDue;
+
+/*!
+ * @brief The windowed frame being transformed.
+ */
+static int16_t Work[FFT_SIZE_MAX];
+
+/*!
+ * @brief Magnitude of each bin of the last frame.
+ */
+static uint16_t Magnitudes[FFT_SIZE_MAX / 2 + 1];
+
+/*!
+ * @brief Window and transform the frame, and find the peaks.
+ * @param peaks Filled with the peaks.
+ */
+static void Analyse(TSpectrumPeaks * const peaks)
+{
+	//Oldest sample first
+	for (uint16_t n = 0; n < FrameSize; n++)
+	{
+		Work[n] = FrameSamples[(FrameNext + n) & (FrameSize - 1)];
+	}
+	Fft_HannWindow(Work, FrameSize, SAMPLE_SHIFT);
+	(void) Fft_RealMagnitudes(Work, FrameSize, Magnitudes);
+
+	peaks->axis = FrameAxis;
+	peaks->size = FrameSize;
+	peaks->count = 0;
+	//Local maxima above DC, kept largest first
+	for (uint16_t k = 1; k < FrameSize / 2; k++)
+	{
+		uint16_t magnitude = Magnitudes[k];
+		if ((magnitude == 0) || (magnitude <= Magnitudes[k - 1]) || (magnitude < Magnitudes[k + 1]))
+		{
+			continue;
+		}
+		uint8_t slot = peaks->count;
+		for (; (slot > 0) && (peaks->peaks[slot - 1].magnitude < magnitude); slot--)
+		{
+			if (slot < SPECTRUM_PEAKS)
+			{
+				peaks->peaks[slot] = peaks->peaks[slot - 1];
+			}
+		}
+		if (slot < SPECTRUM_PEAKS)
+		{
+			peaks->peaks[slot].bin = k;
+			peaks->peaks[slot].magnitude = magnitude;
+			if (peaks->count < SPECTRUM_PEAKS)
+			{
+				peaks->count++;
+			}
+		}
+	}
+}
+
+BOOL Spectrum_Init()
+{
+	Size = 0;
+	Axis = ACCEL_X;
+	SettingsChanged = bTRUE;
+	return bTRUE;
+}
+
+BOOL Spectrum_Set(const uint16_t size, const uint8_t axis)
+{
+	if (((size != 0) && ((size < FFT_SIZE_MIN) || (size > FFT_SIZE_MAX) || (size & (size - 1)))) || (axis > ACCEL_Z))
+	{
+		return bFALSE;
+	}
+	Size = size;
+	Axis = axis;
+	SettingsChanged = bTRUE;
+	return bTRUE;
+}
+
+uint16_t Spectrum_GetSize()
+{
+	return Size;
+}
+
+uint8_t Spectrum_GetAxis()
+{
+	return Axis;
+}
+
+BOOL Spectrum_Add(const TAccelSample * const sample, TSpectrumPeaks * const peaks)
+{
+	if (SettingsChanged)
+	{
+		SettingsChanged = bFALSE;
+		FrameSize = Size;
+		FrameAxis = Axis;
+		FrameNext = 0;
+		//The first frame is a whole one
+		FrameDue = FrameSize;
+	}
+	if (FrameSize == 0)
+	{
+		return bFALSE;
+	}
+
+	FrameSamples[FrameNext] = sample->axes[FrameAxis];
+	FrameNext = (FrameNext + 1) & (FrameSize - 1);
+	if (--FrameDue != 0)
+	{
+		return bFALSE;
+	}
+	//Half a frame on, so each sample is in two frames
+	FrameDue = FrameSize / 2;
+	Analyse(peaks);
+	return bTRUE;
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,82 @@
+/*! @file
+ *
+ *  @brief Spectrum analysis of one accelerometer axis.
+ *
+ *  Frames of samples overlapping by half are Hann windowed and transformed,
+ *  the largest peaks of each frame are reported in place of the samples.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-15
+ */
+/*!
+**  @addtogroup spectrum_module Spectrum module documentation
+**  @{
+*/
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Peaks reported for each frame.
+ */
+#define SPECTRUM_PEAKS 4
+
+/*!
+ * @brief The largest peaks of one frame.
+ */
+typedef struct
+{
+  uint8_t axis;                         /*!< ACCEL_X, ACCEL_Y or ACCEL_Z. */
+  uint16_t size;                        /*!< Samples in the frame, bin k is k / size of the sample rate. */
+  uint8_t count;                        /*!< Number of peaks found. */
+  struct
+  {
+    uint16_t bin;                       /*!< Frequency bin of the peak. */
+    uint16_t magnitude;                 /*!< About the amplitude of the peak, in counts. */
+  } peaks[SPECTRUM_PEAKS];              /*!< Largest first. */
+} TSpectrumPeaks;
+
+/*! @brief Sets up the analysis, turned off.
+ *
+ *  @return BOOL - TRUE if the module was successfully initialized.
+ */
+BOOL Spectrum_Init();
+
+/*! @brief Sets the frame size and the axis analysed.
+ *
+ *  The samples already collected are discarded.
+ *  @param size Samples in each frame, a power of 2 from FFT_SIZE_MIN to FFT_SIZE_MAX, or 0 to turn the analysis off.
+ *  @param axis ACCEL_X, ACCEL_Y or ACCEL_Z.
+ *  @return BOOL - TRUE if the settings are valid.
+ */
+BOOL Spectrum_Set(const uint16_t size, const uint8_t axis);
+
+/*!
+ * @brief Gets the frame size, 0 when the analysis is off.
+ * @return uint16_t
+ */
+uint16_t Spectrum_GetSize();
+
+/*!
+ * @brief Gets the axis analysed.
+ * @return uint8_t
+ */
+uint8_t Spectrum_GetAxis();
+
+/*! @brief Adds a sample to the frame, analysing it each time half a frame has arrived.
+ *
+ *  @param sample The sample.
+ *  @param peaks Filled with the peaks of the frame when it is analysed.
+ *  @return BOOL - TRUE if the frame was analysed.
+ */
+BOOL Spectrum_Add(const TAccelSample * const sample, TSpectrumPeaks * const peaks);
+
+#endif
+
+/*!
+** @}
+*/
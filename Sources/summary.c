@@ -0,0 +1,150 @@
+/*! @file
+ *
+ *  @brief Implementation of the window summaries.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-16
+ */
+/*!
+**  @addtogroup summary_module Summary module documentation
+**  @{
+*/
+#include "summary.h"
+
+#include "fixed.h"
+
+/*!
+ * @brief The running statistics of one axis.
+ */
+typedef struct
+{
+  int16_t min;
+  int16_t max;
+  int32_t sum;
+  uint64_t sumOfSquares;
+  uint16_t crossings;
+  int16_t reference;      /*!< Mean of the window before, crossings are counted about it. */
+  int8_t side;            /*!< Side of the reference the last sample was on, 0 before the first. */
+} TAxisStatistics;
+
+/*!
+ * @brief Window length as set by Summary_SetWindow, 0 when off.
+ */
+static volatile uint16_t Window = 0;
+
+/*!
+ * @brief Asserted when the window length has changed and the window needs clearing.
+ */
+static volatile BOOL WindowChanged;
+
+/*!
+ * @brief Window length being collected, only touched by Summary_Add.
+ */
+static uint16_t WindowLength;
+
+/*!
+ * @brief Samples collected in the window.
+ */
+static uint16_t Collected;
+
+/*!
+ * @brief Statistics of each axis.
+ */
+static TAxisStatistics Axes[3];
+
+/*!
+ * @brief Start a new window.
+ */
+static void StartWindow()
+{
+	Collected = 0;
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		Axes[axis].min = INT16_MAX;
+		Axes[axis].max = INT16_MIN;
+		Axes[axis].sum = 0;
+		Axes[axis].sumOfSquares = 0;
+		Axes[axis].crossings = 0;
+	}
+}
+
+BOOL Summary_Init()
+{
+	Window = 0;
+	WindowChanged = bTRUE;
+	return bTRUE;
+}
+
+BOOL Summary_SetWindow(const uint16_t window)
+{
+	Window = window;
+	WindowChanged = bTRUE;
+	return bTRUE;
+}
+
+uint16_t Summary_GetWindow()
+{
+	return Window;
+}
+
+BOOL Summary_Add(const TAccelSample * const sample, TSummary * const summary)
+{
+	if (WindowChanged)
+	{
+		WindowChanged = bFALSE;
+		WindowLength = Window;
+		StartWindow();
+		for (uint8_t axis = 0; axis < 3; axis++)
+		{
+			Axes[axis].reference = 0;
+			Axes[axis].side = 0;
+		}
+	}
+	if (WindowLength == 0)
+	{
+		return bFALSE;
+	}
+
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		TAxisStatistics * const statistics = &Axes[axis];
+		int16_t value = sample->axes[axis];
+		statistics->min = (value < statistics->min) ? value : statistics->min;
+		statistics->max = (value > statistics->max) ? value : statistics->max;
+		statistics->sum += value;
+		statistics->sumOfSquares += (uint32_t) ((int32_t) value * value);
+
+		//A sample on the reference stays on the side it was
+		int8_t side = (value > statistics->reference) ? 1 : ((value < statistics->reference) ? -1 : statistics->side);
+		if (statistics->side && (side != statistics->side))
+		{
+			statistics->crossings++;
+		}
+		statistics->side = side;
+	}
+
+	if (++Collected < WindowLength)
+	{
+		return bFALSE;
+	}
+
+	summary->samples = Collected;
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		TAxisStatistics * const statistics = &Axes[axis];
+		int16_t mean = (int16_t) (statistics->sum / Collected);
+		summary->values[axis][SUMMARY_MIN] = (uint16_t) statistics->min;
+		summary->values[axis][SUMMARY_MAX] = (uint16_t) statistics->max;
+		summary->values[axis][SUMMARY_MEAN] = (uint16_t) mean;
+		summary->values[axis][SUMMARY_RMS] = Fixed_SquareRoot((uint32_t) (statistics->sumOfSquares / Collected));
+		summary->values[axis][SUMMARY_PEAK_TO_PEAK] = (uint16_t) (statistics->max - statistics->min);
+		summary->values[axis][SUMMARY_ZERO_CROSSINGS] = statistics->crossings;
+		statistics->reference = mean;
+	}
+	StartWindow();
+	return bTRUE;
+}
+
+/*!
+** @}
+*/
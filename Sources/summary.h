@@ -0,0 +1,85 @@
+/*! @file
+ *
+ *  @brief Summaries of windows of accelerometer samples.
+ *
+ *  The samples are split into windows of a set length, and each window is reported
+ *  as a summary of each axis in place of its samples. Every statistic is kept
+ *  up to date as the samples arrive, so each sample costs the same whatever the window.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-16
+ */
+/*!
+**  @addtogroup summary_module Summary module documentation
+**  @{
+*/
+#ifndef SUMMARY_H
+#define SUMMARY_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief The statistics in a summary, in the order they are sent.
+ */
+typedef enum
+{
+  SUMMARY_MIN = 0,
+  SUMMARY_MAX = 1,
+  SUMMARY_MEAN = 2,
+  SUMMARY_RMS = 3,
+  SUMMARY_PEAK_TO_PEAK = 4,
+  SUMMARY_ZERO_CROSSINGS = 5
+} TSummaryStatistic;
+
+/*!
+ * @brief Number of statistics in a summary.
+ */
+#define SUMMARY_STATISTICS 6
+
+/*!
+ * @brief The summary of one window.
+ */
+typedef struct
+{
+  uint16_t samples;                       /*!< Samples in the window. */
+  uint16_t values[3][SUMMARY_STATISTICS]; /*!< Each TSummaryStatistic of each axis, the min, max and mean are signed. */
+} TSummary;
+
+/*! @brief Sets up the summaries, turned off.
+ *
+ *  @return BOOL - TRUE if the module was successfully initialized.
+ */
+BOOL Summary_Init();
+
+/*! @brief Sets the window length.
+ *
+ *  The window being collected is discarded.
+ *  @param window Samples in each window, or 0 to turn the summaries off.
+ *  @return BOOL - TRUE if the window is valid.
+ */
+BOOL Summary_SetWindow(const uint16_t window);
+
+/*!
+ * @brief Gets the window length, 0 when the summaries are off.
+ * @return uint16_t
+ */
+uint16_t Summary_GetWindow();
+
+/*! @brief Adds a sample to the window.
+ *
+ *  Zero crossings are counted about the mean of the window before,
+ *  so an offset such as gravity doesn't hide them.
+ *  @param sample The sample.
+ *  @param summary Filled with the summary when the window is complete.
+ *  @return BOOL - TRUE if the window is complete.
+ */
+BOOL Summary_Add(const TAccelSample * const sample, TSummary * const summary);
+
+#endif
+
+/*!
+** @}
+*/
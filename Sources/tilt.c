@@ -0,0 +1,102 @@
+/*! @file
+ *
+ *  @brief Implementation of the tilt angles.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-18
+ */
+/*!
+**  @addtogroup tilt_module Tilt module documentation
+**  @{
+*/
+#include "tilt.h"
+
+#include "fixed.h"
+
+/*!
+ * @brief Asserted when the angles are sent in place of the samples.
+ */
+static volatile BOOL On = bFALSE;
+
+/*!
+ * @brief Smoothing shift as set by Tilt_Set.
+ */
+static volatile uint8_t Smoothing = 0;
+
+/*!
+ * @brief Asserted when the settings have changed and the smoothing needs to start again.
+ */
+static volatile BOOL SettingsChanged;
+
+/*!
+ * @brief Smoothed pitch and roll, the binary angle in the top 16 bits so they wrap with it.
+ */
+static uint32_t Smoothed[2];
+
+BOOL Tilt_Init()
+{
+	On = bFALSE;
+	Smoothing = 0;
+	SettingsChanged = bTRUE;
+	return bTRUE;
+}
+
+BOOL Tilt_Set(const BOOL on, const uint8_t smoothing)
+{
+	if (smoothing > TILT_SMOOTHING_MAX)
+	{
+		return bFALSE;
+	}
+	Smoothing = smoothing;
+	On = on;
+	SettingsChanged = bTRUE;
+	return bTRUE;
+}
+
+BOOL Tilt_IsOn()
+{
+	return On;
+}
+
+uint8_t Tilt_GetSmoothing()
+{
+	return Smoothing;
+}
+
+void Tilt_Compute(const TAccelSample * const sample, TTilt * const tilt)
+{
+	int32_t x = sample->axes[ACCEL_X];
+	int32_t y = sample->axes[ACCEL_Y];
+	int32_t z = sample->axes[ACCEL_Z];
+
+	//Pitch against the whole of gravity in the Y-Z plane, so it holds up as the roll goes past a quarter turn
+	tilt->pitch = Fixed_Atan2(-x, Fixed_SquareRoot((uint32_t) (y * y) + (uint32_t) (z * z)));
+	tilt->roll = Fixed_Atan2(y, z);
+}
+
+void Tilt_Add(const TAccelSample * const sample, TTilt * const tilt)
+{
+	TTilt raw;
+	Tilt_Compute(sample, &raw);
+
+	uint8_t shift = Smoothing;
+	if (SettingsChanged)
+	{
+		SettingsChanged = bFALSE;
+		Smoothed[0] = (uint32_t) (uint16_t) raw.pitch << 16;
+		Smoothed[1] = (uint32_t) (uint16_t) raw.roll << 16;
+	}
+
+	//The difference is taken the short way round, so the roll crosses half a turn cleanly
+	int32_t step = (int32_t) (((uint32_t) (uint16_t) raw.pitch << 16) - Smoothed[0]);
+	Smoothed[0] += (uint32_t) (step >> shift);
+	step = (int32_t) (((uint32_t) (uint16_t) raw.roll << 16) - Smoothed[1]);
+	Smoothed[1] += (uint32_t) (step >> shift);
+
+	tilt->pitch = (int16_t) (Smoothed[0] >> 16);
+	tilt->roll = (int16_t) (Smoothed[1] >> 16);
+}
+
+/*!
+** @}
+*/
@@ -0,0 +1,86 @@
+/*! @file
+ *
+ *  @brief Tilt angles of the tower from the accelerometer samples.
+ *
+ *  Pitch and roll are worked out from the direction of gravity in fixed-point
+ *  with Fixed_Atan2, and can be smoothed before they are sent in place of the samples.
+ *  The angles are binary, FIXED_ANGLE_TURN to a whole turn.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-18
+ */
+/*!
+**  @addtogroup tilt_module Tilt module documentation
+**  @{
+*/
+#ifndef TILT_H
+#define TILT_H
+
+// new types
+#include "types.h"
+
+#include "accel.h"
+
+/*!
+ * @brief Largest smoothing shift.
+ */
+#define TILT_SMOOTHING_MAX 8
+
+/*!
+ * @brief The tilt of the tower.
+ */
+typedef struct
+{
+  int16_t pitch;    /*!< Rotation about the Y axis, a quarter turn either way. */
+  int16_t roll;     /*!< Rotation about the X axis, half a turn either way. */
+} TTilt;
+
+/*! @brief Sets up the tilt angles, turned off.
+ *
+ *  @return BOOL - TRUE if the module was successfully initialized.
+ */
+BOOL Tilt_Init();
+
+/*! @brief Turns the angles on or off and sets their smoothing.
+ *
+ *  Smoothing is a first order low-pass of the angles, each new angle moves the output
+ *  1 / 2^smoothing of the way, so the noise of one sample is spread over about 2^smoothing samples.
+ *  It is the accelerometer half of a complementary filter, the tower has no gyro for the other half.
+ *  The smoothing starts again from the next sample.
+ *  @param on bTRUE to send angles in place of the samples.
+ *  @param smoothing The shift, 0 for no smoothing, at most TILT_SMOOTHING_MAX.
+ *  @return BOOL - TRUE if the smoothing is valid.
+ */
+BOOL Tilt_Set(const BOOL on, const uint8_t smoothing);
+
+/*!
+ * @brief Gets whether the angles are sent in place of the samples.
+ * @return BOOL
+ */
+BOOL Tilt_IsOn();
+
+/*!
+ * @brief Gets the smoothing shift.
+ * @return uint8_t
+ */
+uint8_t Tilt_GetSmoothing();
+
+/*! @brief Works out the tilt of one sample, with no smoothing.
+ *
+ *  @param sample The sample.
+ *  @param tilt Filled with the angles.
+ */
+void Tilt_Compute(const TAccelSample * const sample, TTilt * const tilt);
+
+/*! @brief Works out the tilt of the next sample, and smooths it.
+ *
+ *  @param sample The sample.
+ *  @param tilt Filled with the smoothed angles.
+ */
+void Tilt_Add(const TAccelSample * const sample, TTilt * const tilt);
+
+#endif
+
+/*!
+** @}
+*/
@@ -15,17 +15,52 @@
 #include "MK70F12.h"
 #include "OS.h"
 
+#include "Cpu.h"
+
 #include "LEDs.h"
 
 #define PIT_CHANNEL_COUNT 8
 
 static TTimer const *TimerCache[PIT_CHANNEL_COUNT] = {0};
 
+/*!
+ * @brief Counter at the last interrupt of each channel.
+ */
+static uint16_t LastCount[PIT_CHANNEL_COUNT];
+
+/*!
+ * @brief Asserted once a channel has had an interrupt since its jitter was read.
+ */
+static BOOL Counted[PIT_CHANNEL_COUNT];
+
+/*!
+ * @brief Time between the interrupts of each channel.
+ */
+static TTimerJitter Jitter[PIT_CHANNEL_COUNT];
+
+/*!
+ * @brief Clear the jitter of a channel.
+ * @param channelNb The channel.
+ */
+static void ClearJitter(const uint8_t channelNb)
+{
+	Counted[channelNb] = bFALSE;
+	Jitter[channelNb].count = 0;
+	Jitter[channelNb].minInterval = UINT16_MAX;
+	Jitter[channelNb].maxInterval = 0;
+}
+
 BOOL Timer_Init()
 {
 	SIM_SCGC6 |= SIM_SCGC6_FTM0_MASK;
 
+	for (uint8_t i = 0; i < PIT_CHANNEL_COUNT; i++)
+	{
+		ClearJitter(i);
+	}
+
 	FTM0_SC |= FTM_SC_CLKS(FTM_SC_CLKS_FIXED_FREQUENCY_CLOCK);
+	return bTRUE;
 }
 
 BOOL Timer_Set(const TTimer* const aTimer)
@@ -48,6 +83,7 @@ BOOL Timer_Set(const TTimer* const aTimer)
 		return bFALSE;
 	}
 	TimerCache[aTimer->channelNb] = aTimer;
+	return bTRUE;
 }
 
 BOOL Timer_Start(const TTimer* const aTimer)
@@ -58,19 +94,63 @@ BOOL Timer_Start(const TTimer* const aTimer)
 	}
 	FTM0_CnSC(aTimer->channelNb) = (FTM_CnSC_MSA_MASK | FTM_CnSC_CHIE_MASK);
 	FTM0_CnV(aTimer->channelNb) = FTM0_CNT + aTimer->initialCount;
+	return bTRUE;
+}
+
+BOOL Timer_Stop(const TTimer* const aTimer)
+{
+	if (TimerCache[aTimer->channelNb] != aTimer)
+	{
+		return bFALSE;
+	}
+	FTM0_CnSC(aTimer->channelNb) &= ~(FTM_CnSC_CHIE_MASK | FTM_CnSC_CHF_MASK);
+	return bTRUE;
+}
+
+void Timer_GetJitter(const uint8_t channelNb, TTimerJitter * const jitter)
+{
+	if (channelNb >= PIT_CHANNEL_COUNT)
+	{
+		return;
+	}
+	EnterCritical();
+	*jitter = Jitter[channelNb];
+	ClearJitter(channelNb);
+	ExitCritical();
 }
 
 void __attribute__ ((interrupt)) FTM0_ISR(void)
 {
 	OS_ISREnter();
+	uint16_t count = FTM0_CNT;
   uint32_t status = FTM0_STATUS;
 	for (size_t i = 0; i < PIT_CHANNEL_COUNT; i++)
 	{
 		//if there is no timer for this channel, continue
-		//if there is no status for this channel, continue
-		if (TimerCache[i] && (status & (1 << i)))
+		//if there is no status for this channel, or it has been stopped, continue
+		if (TimerCache[i] && (status & (1 << i)) && (FTM0_CnSC(i) & FTM_CnSC_CHIE_MASK))
 		{
 			FTM0_CnSC(i) &= ~FTM_CnSC_CHF_MASK;
+			if (TimerCache[i]->period)
+			{
+				//From the last compare rather than now, so the ISR latency doesn't add up
+				FTM0_CnV(i) = (FTM0_CnV(i) + TimerCache[i]->period) & FTM_CnV_VAL_MASK;
+			}
+			else
+			{
+				FTM0_CnSC(i) &= ~FTM_CnSC_CHIE_MASK;
+			}
+
+			if (Counted[i])
+			{
+				uint16_t interval = count - LastCount[i];
+				Jitter[i].count++;
+				Jitter[i].minInterval = (interval < Jitter[i].minInterval) ? interval : Jitter[i].minInterval;
+				Jitter[i].maxInterval = (interval > Jitter[i].maxInterval) ? interval : Jitter[i].maxInterval;
+			}
+			LastCount[i] = count;
+			Counted[i] = bTRUE;
+
 			(TimerCache[i]->userFunction)(TimerCache[i]->userArguments);
 		}
 	}
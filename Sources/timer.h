@@ -51,8 +51,19 @@ typedef struct
   } ioType;
   void (*userFunction)(void*);
   void *userArguments;
+  uint16_t period;
 } TTimer;
 
+/*!
+ * @brief Time between the interrupts of a channel.
+ */
+typedef struct
+{
+  uint32_t count;         /*!< Intervals measured. */
+  uint16_t minInterval;   /*!< Shortest, in FTM counts. */
+  uint16_t maxInterval;   /*!< Longest, in FTM counts. */
+} TTimerJitter;
+
 /*!
  * @brief No clock; stopped.
  */
@@ -82,6 +93,7 @@ BOOL Timer_Init();
  *      inputDetection is the type of input capture detection.
  *    userFunction is a pointer to a user callback function.
  *    userArguments is a pointer to the user arguments to use with the user callback function.
+ *    period is the count between the later output compare events, or 0 for a one-shot timer.
  *  @return BOOL - TRUE if the timer was set up successfully.
  *  @note Assumes the FTM has been initialized.
  */
@@ -96,10 +108,29 @@ BOOL Timer_Set(const TTimer* const aTimer);
  */
 BOOL Timer_Start(const TTimer* const aTimer);
 
+/*! @brief Stops a timer, so its callback isn't called again until it is started.
+ *
+ *  @param aTimer is a structure containing the parameters to be used in setting up the timer channel.
+ *  @return BOOL - TRUE if the timer was stopped successfully.
+ *  @note Assumes the FTM has been initialized.
+ */
+BOOL Timer_Stop(const TTimer* const aTimer);
+
+/*! @brief Reads and clears the time between the interrupts of a channel.
+ *
+ *  The jitter of a periodic timer is maxInterval - minInterval.
+ *  Intervals are taken modulo the 16-bit counter.
+ *  @param channelNb The channel.
+ *  @param jitter is filled with the intervals since the last call.
+ */
+void Timer_GetJitter(const uint8_t channelNb, TTimerJitter * const jitter);
+
 
 /*! @brief Interrupt service routine for the FTM.
  *
  *  If a timer channel was set up as output compare, then the user callback function will be called.
+ *  A periodic timer is moved on by its period from the last compare, so it doesn't drift,
+ *  a one-shot timer is stopped.
  *  @note Assumes the FTM has been initialized.
  */
 void __attribute__ ((interrupt)) FTM0_ISR(void);
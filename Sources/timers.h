@@ -10,7 +10,7 @@
 
 //TC = Timer Channel
 
-#define TC_PACKETTIMER 0
+#define TC_WHEEL 0
 #define TC_ACCTIMER 1
 #define TC_TOGGLE 2
 
@@ -0,0 +1,318 @@
+/*! @file
+ *
+ *  @brief Implementation of the firmware update over the serial protocol.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-06
+ */
+/*!
+**  @addtogroup update_module Update module documentation
+**  @{
+*/
+#include "update.h"
+
+#include "Flash.h"
+#include "OS.h"
+#include "UART.h"
+
+#include "Cpu.h"
+#include "MK70F12.h"
+
+/*!
+ * @brief Key which must accompany a write to SCB_AIRCR.
+ */
+#define AIRCR_VECTKEY 0x5FA
+
+/*!
+ * @brief The CRC-32 generator polynomial.
+ */
+#define CRC32_POLYNOMIAL 0x04C11DB7LU
+
+/*!
+ * @brief Where firmware from before the swap layout kept the non-volatile variables, now the start of an image.
+ */
+#define LEGACY_DATA_START FLASH_INACTIVE_BLOCK_START
+
+/*!
+ * @brief Asserted between Update_Begin and Update_Commit.
+ */
+static BOOL Receiving = bFALSE;
+
+/*!
+ * @brief Asserted once the swap is complete.
+ */
+static BOOL Complete = bFALSE;
+
+/*!
+ * @brief Size of the image being received.
+ */
+static uint32_t ImageSize;
+
+/*!
+ * @brief Number of bytes of the image received so far.
+ */
+static uint32_t Received;
+
+/*!
+ * @brief The phrase currently being filled.
+ */
+static uint8_t Phrase[8];
+
+/*!
+ * @brief Number of bytes in Phrase.
+ */
+static uint8_t PhraseFill;
+
+/*!
+ * @brief Fill the phrase buffer with the erased value.
+ */
+static void ClearPhrase()
+{
+	for (size_t i = 0; i < sizeof(Phrase); i++)
+	{
+		Phrase[i] = 0xFF;
+	}
+	PhraseFill = 0;
+}
+
+/*!
+ * @brief Program the phrase buffer to its place in the inactive block.
+ *
+ * The image was erased by Update_Begin, the programming is left to run while the next bytes arrive.
+ * @param address The address of the phrase.
+ * @return bTRUE if the phrase was launched.
+ */
+static BOOL ProgramPhrase(const uint32_t address)
+{
+	BOOL result = Flash_ProgramPhrase(address, Phrase, bFALSE);
+	ClearPhrase();
+	return result;
+}
+
+/*!
+ * @brief Calculate the CRC-32 (as used by zlib) of the image in the inactive block.
+ * @param size Size of the image in bytes.
+ * @return The CRC.
+ */
+static uint32_t ImageCRC(const uint32_t size)
+{
+	//Reflected input and output, final XOR, seeded with all ones
+	CRC_CTRL = CRC_CTRL_TCRC_MASK | CRC_CTRL_TOT(1) | CRC_CTRL_TOTR(2) | CRC_CTRL_FXOR_MASK | CRC_CTRL_WAS_MASK;
+	CRC_GPOLY = CRC32_POLYNOMIAL;
+	CRC_CRC = 0xFFFFFFFFLU;
+	CRC_CTRL &= ~CRC_CTRL_WAS_MASK;
+
+	for (uint32_t i = 0; i < size; i++)
+	{
+		CRC_CRCLL = _FB(FLASH_INACTIVE_BLOCK_START + i);
+	}
+	return CRC_CRC;
+}
+
+/*!
+ * @brief Copy the data sector into the active block.
+ *
+ * After the swap the active block becomes the inactive one,
+ * so the non-volatile variables end up back at FLASH_DATA_START.
+ * @return bTRUE if successful.
+ */
+static BOOL CarryDataSector()
+{
+	uint8_t data[8];
+	for (size_t i = 0; i < sizeof(data); i++)
+	{
+		data[i] = _FB(FLASH_DATA_START + i);
+	}
+
+	//We execute from the block being erased, only the Flash wait runs from RAM
+	EnterCritical();
+	BOOL result = Flash_EraseSector(FLASH_DATA_OFFSET, bTRUE) && Flash_ProgramPhrase(FLASH_DATA_OFFSET, data, bTRUE);
+	ExitCritical();
+	return result;
+}
+
+/*!
+ * @brief Move the non-volatile variables of firmware from before the swap layout to FLASH_DATA_START.
+ *
+ * Until the swap system has been initialized no image has been received, so anything
+ * at LEGACY_DATA_START was written by the old firmware. It is left there, the next update erases it.
+ * @return bTRUE if successful.
+ */
+static BOOL MigrateDataSector()
+{
+	TFlashSwapMode mode;
+	if (!Flash_SwapControl(FLASH_SWAP_CONTROL_REPORT, &mode))
+	{
+		return bFALSE;
+	}
+	if ((mode != FLASH_SWAP_UNINITIALIZED) || (_FP(FLASH_DATA_START) != 0xFFFFFFFFFFFFFFFFLLU)
+			|| (_FP(LEGACY_DATA_START) == 0xFFFFFFFFFFFFFFFFLLU))
+	{
+		return bTRUE;
+	}
+
+	uint8_t data[8];
+	for (size_t i = 0; i < sizeof(data); i++)
+	{
+		data[i] = _FB(LEGACY_DATA_START + i);
+	}
+	return Flash_ProgramPhrase(FLASH_DATA_START, data, bTRUE) && Flash_Wait();
+}
+
+BOOL Update_Init()
+{
+	SIM_SCGC6 |= SIM_SCGC6_CRC_MASK;
+	return MigrateDataSector();
+}
+
+BOOL Update_Begin(const uint32_t size)
+{
+	if ((size == 0) || (size > UPDATE_IMAGE_MAX_SIZE) || Complete)
+	{
+		return bFALSE;
+	}
+
+	/*
+	 * Walk the swap system into the update-erased state.
+	 * Each pass moves one state forward, a previously abandoned update resumes part way.
+	 */
+	TFlashSwapMode mode;
+	if (!Flash_SwapControl(FLASH_SWAP_CONTROL_REPORT, &mode))
+	{
+		return bFALSE;
+	}
+	for (uint8_t tries = 0; mode != FLASH_SWAP_UPDATE_ERASED; tries++)
+	{
+		BOOL result;
+		switch (mode)
+		{
+		case FLASH_SWAP_UNINITIALIZED:
+			result = Flash_SwapControl(FLASH_SWAP_CONTROL_INITIALIZE, &mode);
+			break;
+		case FLASH_SWAP_READY:
+			result = Flash_SwapControl(FLASH_SWAP_CONTROL_SET_UPDATE, &mode);
+			break;
+		case FLASH_SWAP_UPDATE:
+			result = Flash_EraseSector(FLASH_INACTIVE_BLOCK_START + FLASH_SWAP_INDICATOR_OFFSET, bTRUE)
+					&& Flash_SwapControl(FLASH_SWAP_CONTROL_REPORT, &mode);
+			break;
+		default:
+			//Complete, waiting on a reset
+			result = bFALSE;
+			break;
+		}
+		if (!result || tries > 3)
+		{
+			return bFALSE;
+		}
+	}
+
+	//Erase the whole image now, the host waits for the acknowledgement before sending any of it
+	for (uint32_t offset = 0; offset < size; offset += FLASH_SECTOR_SIZE)
+	{
+		if (!Flash_EraseSector(FLASH_INACTIVE_BLOCK_START + offset, bTRUE))
+		{
+			return bFALSE;
+		}
+	}
+
+	ImageSize = size;
+	Received = 0;
+	ClearPhrase();
+	Receiving = bTRUE;
+	return bTRUE;
+}
+
+BOOL Update_Write(const uint8_t * const data, const size_t length)
+{
+	if (!Receiving)
+	{
+		return bFALSE;
+	}
+	for (size_t i = 0; i < length; i++)
+	{
+		//Padding in the last packet is dropped
+		if (Received >= ImageSize)
+		{
+			break;
+		}
+		Phrase[PhraseFill++] = data[i];
+		Received++;
+		if (PhraseFill == sizeof(Phrase))
+		{
+			if (!ProgramPhrase(FLASH_INACTIVE_BLOCK_START + Received - sizeof(Phrase)))
+			{
+				Receiving = bFALSE;
+				return bFALSE;
+			}
+		}
+	}
+	return bTRUE;
+}
+
+BOOL Update_Commit(const uint32_t crc)
+{
+	if (!Receiving || (Received != ImageSize))
+	{
+		return bFALSE;
+	}
+	Receiving = bFALSE;
+
+	//Flush the partial phrase, padded with erased bytes
+	if (PhraseFill && !ProgramPhrase(FLASH_INACTIVE_BLOCK_START + Received - PhraseFill))
+	{
+		return bFALSE;
+	}
+	//Also invalidates the Flash cache, so the CRC is over what was programmed
+	if (!Flash_Wait())
+	{
+		return bFALSE;
+	}
+
+	if (ImageCRC(ImageSize) != crc)
+	{
+		return bFALSE;
+	}
+
+	if (!CarryDataSector())
+	{
+		return bFALSE;
+	}
+
+	TFlashSwapMode mode;
+	if (!Flash_SwapControl(FLASH_SWAP_CONTROL_SET_COMPLETE, &mode) || (mode != FLASH_SWAP_COMPLETE))
+	{
+		return bFALSE;
+	}
+	Complete = bTRUE;
+	return bTRUE;
+}
+
+BOOL Update_IsComplete()
+{
+	return Complete;
+}
+
+BOOL Update_IsReceiving()
+{
+	return Receiving;
+}
+
+void Update_Reset()
+{
+	//Let the acknowledgement leave before the reset
+	while (TxFIFO.NbBytes)
+	{
+		OS_TimeDelay(1);
+	}
+	OS_TimeDelay(2);
+
+	SCB_AIRCR = SCB_AIRCR_VECTKEY(AIRCR_VECTKEY) | SCB_AIRCR_SYSRESETREQ_MASK;
+	for (;;)
+	{
+	}
+}
+
+/*!
+** @}
+*/
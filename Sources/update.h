@@ -0,0 +1,81 @@
+/*! @file
+ *
+ *  @brief Firmware update over the serial protocol.
+ *
+ *  Streams a new image into the inactive program Flash block, verifies it
+ *  with a CRC and uses the FTFE swap system to make it the active block on the next reset.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-06
+ */
+/*!
+**  @addtogroup update_module Update module documentation
+**  @{
+*/
+#ifndef UPDATE_H
+#define UPDATE_H
+
+#include "types.h"
+
+/*!
+ * @brief The largest image which can be received.
+ * The top two sectors of each block hold the data sector and the swap indicator.
+ */
+#define UPDATE_IMAGE_MAX_SIZE 0x0007E000LU
+
+/*! @brief Sets up the update module before first use.
+ *
+ *  Moves the non-volatile variables of firmware from before the swap layout.
+ *  @return BOOL - TRUE if the update module was successfully initialized.
+ *  @note Requires the flash module to be started, and must run before any non-volatile variable is read.
+ */
+BOOL Update_Init();
+
+/*! @brief Starts receiving a new image.
+ *
+ *  Puts the swap system into the update state, erases the inactive swap indicator
+ *  and the sectors the image will take, which takes up to about 100 ms a sector.
+ *  @param size The size of the image in bytes.
+ *  @return BOOL - TRUE if the update was started.
+ */
+BOOL Update_Begin(const uint32_t size);
+
+/*! @brief Appends bytes to the image.
+ *
+ *  Each completed phrase is programmed in the background while the next bytes arrive.
+ *  @param data The bytes to append.
+ *  @param length The number of bytes.
+ *  @return BOOL - TRUE if the bytes were accepted.
+ */
+BOOL Update_Write(const uint8_t * const data, const size_t length);
+
+/*! @brief Verifies the image and marks the swap as complete.
+ *
+ *  @param crc The expected CRC-32 of the image.
+ *  @return BOOL - TRUE if the image is valid and will be run after the next reset.
+ */
+BOOL Update_Commit(const uint32_t crc);
+
+/*!
+ * @brief Check if an update has been committed and is waiting for a reset.
+ * @return BOOL - TRUE if the blocks will swap on the next reset.
+ */
+BOOL Update_IsComplete();
+
+/*!
+ * @brief Check if an image is being received.
+ * @return BOOL - TRUE between Update_Begin and Update_Commit.
+ */
+BOOL Update_IsReceiving();
+
+/*! @brief Resets the processor once the transmit FIFO has drained.
+ *
+ *  @note Does not return.
+ */
+void Update_Reset();
+
+#endif
+
+/*!
+** @}
+*/
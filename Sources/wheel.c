@@ -0,0 +1,269 @@
+/*! @file
+ *
+ *  @brief Implementation of the software timers.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-20
+ */
+/*!
+**  @addtogroup wheel_module Wheel module documentation
+**  @{
+*/
+#include "wheel.h"
+
+#include "timer.h"
+
+#include "Cpu.h"
+
+/*!
+ * @brief FTM counts in a tick.
+ */
+#define WHEEL_TICK_COUNT ((CPU_MCGFF_CLK_HZ_CONFIG_0 * WHEEL_TICK_MS + 500) / 1000)
+
+/*!
+ * @brief Mask of a slot index.
+ */
+#define WHEEL_SLOT_MASK (WHEEL_SLOTS - 1)
+
+/*!
+ * @brief The timers in each slot of each wheel, level 0 is the finest.
+ */
+static TWheelTimer *Slots[WHEEL_LEVELS][WHEEL_SLOTS];
+
+/*!
+ * @brief The next tick to be handled, slots are found from it.
+ */
+static uint32_t Next;
+
+/*!
+ * @brief Number of timers running.
+ */
+static uint32_t Running;
+
+/*!
+ * @brief Asserted while the channel is ticking.
+ */
+static BOOL Ticking;
+
+static void Tick(void *arguments);
+
+/*!
+ * @brief The channel which ticks the wheel.
+ */
+static TTimer WheelTimer = { 0,
+		WHEEL_TICK_COUNT,
+		TIMER_FUNCTION_OUTPUT_COMPARE,
+		TIMER_OUTPUT_DISCONNECT,
+		&Tick,
+		(void *) 0,
+		WHEEL_TICK_COUNT };
+
+/*!
+ * @brief Put a timer in the slot for its expiry, must be called in a critical section.
+ * @param timer The timer, not in any slot.
+ */
+static void Link(TWheelTimer * const timer)
+{
+	TWheelTimer **slot;
+	uint32_t delay = timer->expires - Next;
+	if ((int32_t) delay < 0)
+	{
+		//Already due, it goes out with the next tick
+		slot = &Slots[0][Next & WHEEL_SLOT_MASK];
+	}
+	else
+	{
+		if (delay > WHEEL_DELAY_MAX)
+		{
+			delay = WHEEL_DELAY_MAX;
+			timer->expires = Next + delay;
+		}
+		uint8_t level = 0;
+		while ((level < WHEEL_LEVELS - 1) && (delay >> ((level + 1) * WHEEL_SLOT_BITS)))
+		{
+			level++;
+		}
+		slot = &Slots[level][(timer->expires >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK];
+	}
+
+	timer->next = *slot;
+	if (timer->next)
+	{
+		timer->next->pprev = &timer->next;
+	}
+	*slot = timer;
+	timer->pprev = slot;
+}
+
+/*!
+ * @brief Take a timer out of its slot, must be called in a critical section.
+ * @param timer The timer, in a slot.
+ */
+static void Unlink(TWheelTimer * const timer)
+{
+	*timer->pprev = timer->next;
+	if (timer->next)
+	{
+		timer->next->pprev = timer->pprev;
+	}
+	timer->next = NULL;
+	timer->pprev = NULL;
+}
+
+/*!
+ * @brief Move the timers in a slot down to the levels their expiries now fit.
+ * @param level The level, 1 or more.
+ * @param index The slot.
+ * @return The slot, 0 when the wheel has come round and the level above is due too.
+ */
+static uint8_t Cascade(const uint8_t level, const uint8_t index)
+{
+	TWheelTimer *timer = Slots[level][index];
+	Slots[level][index] = NULL;
+	while (timer)
+	{
+		TWheelTimer *next = timer->next;
+		Link(timer);
+		timer = next;
+	}
+	return index;
+}
+
+/*!
+ * @brief Called from the FTM interrupt each tick, runs the timers which are due.
+ * @param arguments Unused.
+ */
+static void Tick(void *arguments)
+{
+	EnterCritical();
+	uint8_t index = Next & WHEEL_SLOT_MASK;
+	if (index == 0)
+	{
+		for (uint8_t level = 1; level < WHEEL_LEVELS; level++)
+		{
+			if (Cascade(level, (Next >> (level * WHEEL_SLOT_BITS)) & WHEEL_SLOT_MASK))
+			{
+				break;
+			}
+		}
+	}
+	Next++;
+
+	//Take the whole slot, a callback can still cancel a timer in it
+	TWheelTimer *batch = Slots[0][index];
+	Slots[0][index] = NULL;
+	if (batch)
+	{
+		batch->pprev = &batch;
+	}
+	ExitCritical();
+
+	for (;;)
+	{
+		EnterCritical();
+		TWheelTimer *timer = batch;
+		if (!timer)
+		{
+			ExitCritical();
+			break;
+		}
+		Unlink(timer);
+		if (timer->period)
+		{
+			//From when it was due, so it doesn't drift
+			timer->expires += timer->period;
+			Link(timer);
+		}
+		else
+		{
+			Running--;
+		}
+		ExitCritical();
+		(timer->userFunction)(timer->userArguments);
+	}
+
+	//Stop ticking once there is nothing left to time
+	EnterCritical();
+	if (!Running)
+	{
+		Ticking = bFALSE;
+		(void) Timer_Stop(&WheelTimer);
+	}
+	ExitCritical();
+}
+
+/*!
+ * @brief Convert a time to ticks, rounding up.
+ * @param ms The time in ms.
+ * @return The ticks, at most WHEEL_DELAY_MAX.
+ */
+static uint32_t MsToTicks(const uint32_t ms)
+{
+	uint32_t ticks = ms / WHEEL_TICK_MS + ((ms % WHEEL_TICK_MS) ? 1 : 0);
+	return (ticks > WHEEL_DELAY_MAX) ? WHEEL_DELAY_MAX : ticks;
+}
+
+BOOL Wheel_Init(const uint8_t channelNb)
+{
+	for (uint8_t level = 0; level < WHEEL_LEVELS; level++)
+	{
+		for (uint8_t index = 0; index < WHEEL_SLOTS; index++)
+		{
+			Slots[level][index] = NULL;
+		}
+	}
+	Next = 0;
+	Running = 0;
+	Ticking = bFALSE;
+	WheelTimer.channelNb = channelNb;
+	return Timer_Set(&WheelTimer);
+}
+
+BOOL Wheel_Start(TWheelTimer * const timer, const uint32_t delay, const uint32_t period)
+{
+	if (!timer->userFunction)
+	{
+		return bFALSE;
+	}
+
+	EnterCritical();
+	if (timer->pprev)
+	{
+		Unlink(timer);
+	}
+	else
+	{
+		Running++;
+	}
+	//The next tick is up to a tick away, so a timer never expires early
+	timer->expires = Next + MsToTicks(delay);
+	timer->period = MsToTicks(period);
+	Link(timer);
+	if (!Ticking)
+	{
+		Ticking = bTRUE;
+		(void) Timer_Start(&WheelTimer);
+	}
+	ExitCritical();
+	return bTRUE;
+}
+
+void Wheel_Cancel(TWheelTimer * const timer)
+{
+	EnterCritical();
+	if (timer->pprev)
+	{
+		Unlink(timer);
+		Running--;
+	}
+	ExitCritical();
+}
+
+BOOL Wheel_IsRunning(const TWheelTimer * const timer)
+{
+	return (timer->pprev != NULL) ? bTRUE : bFALSE;
+}
+
+/*!
+** @}
+*/
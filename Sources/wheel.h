@@ -0,0 +1,99 @@
+/*! @file
+ *
+ *  @brief Software timers on one FTM channel.
+ *
+ *  A hierarchical timing wheel: WHEEL_LEVELS wheels of WHEEL_SLOTS lists, each level
+ *  WHEEL_SLOTS times as coarse as the one below. A timer is linked into the slot of the level
+ *  its delay fits, and moved down a level each time the wheel below comes round,
+ *  so starting or cancelling a timer is a list insert or remove however many are running.
+ *  Every timer due in a tick is taken off the wheel in one go, then their callbacks are run.
+ *  The channel only interrupts while a timer is running.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-20
+ */
+/*!
+**  @addtogroup wheel_module Wheel module documentation
+**  @{
+*/
+#ifndef WHEEL_H
+#define WHEEL_H
+
+// new types
+#include "types.h"
+
+/*!
+ * @brief Length of a tick, the resolution of the timers.
+ */
+#define WHEEL_TICK_MS 10
+
+/*!
+ * @brief Number of wheels.
+ */
+#define WHEEL_LEVELS 4
+
+/*!
+ * @brief log2 of the slots in each wheel.
+ */
+#define WHEEL_SLOT_BITS 6
+
+/*!
+ * @brief Number of slots in each wheel.
+ */
+#define WHEEL_SLOTS (1 << WHEEL_SLOT_BITS)
+
+/*!
+ * @brief Longest delay in ticks, longer ones are cut to it (46 hours).
+ */
+#define WHEEL_DELAY_MAX ((1LU << (WHEEL_LEVELS * WHEEL_SLOT_BITS)) - 1)
+
+/*!
+ * @struct TWheelTimer
+ *  Set up userFunction and userArguments, and leave the rest 0.
+ */
+typedef struct TWheelTimer
+{
+  struct TWheelTimer *next;     /*!< The next timer in the slot. */
+  struct TWheelTimer **pprev;   /*!< What points to this timer, NULL when it isn't running. */
+  uint32_t expires;             /*!< Tick the timer is due. */
+  uint32_t period;              /*!< Ticks between expiries, 0 for a one-shot timer. */
+  void (*userFunction)(void*);  /*!< Called from the FTM interrupt when the timer expires. */
+  void *userArguments;          /*!< Passed to userFunction. */
+} TWheelTimer;
+
+/*! @brief Sets up the wheel with no timers running.
+ *
+ *  @param channelNb The FTM channel which ticks the wheel.
+ *  @return BOOL - TRUE if the wheel was successfully initialized.
+ *  @note Assumes the FTM has been initialized.
+ */
+BOOL Wheel_Init(const uint8_t channelNb);
+
+/*! @brief Starts a timer, or starts it again if it is running.
+ *
+ *  Delays are rounded up to whole ticks. The timer can be started from its own callback.
+ *  @param timer The timer.
+ *  @param delay Time until it first expires, in ms.
+ *  @param period Time between later expiries in ms, or 0 to expire only once.
+ *  @return BOOL - TRUE if the timer was started.
+ */
+BOOL Wheel_Start(TWheelTimer * const timer, const uint32_t delay, const uint32_t period);
+
+/*! @brief Stops a timer, nothing happens if it isn't running.
+ *
+ *  @param timer The timer.
+ */
+void Wheel_Cancel(TWheelTimer * const timer);
+
+/*!
+ * @brief Gets whether a timer is running.
+ * @param timer The timer.
+ * @return BOOL
+ */
+BOOL Wheel_IsRunning(const TWheelTimer * const timer);
+
+#endif
+
+/*!
+** @}
+*/
@@ -0,0 +1,234 @@
+/*! @file
+ *
+ *  @brief Host test of the fixed-point filter pipeline against double precision filters.
+ *
+ *  Not part of the tower build. From the repository root, with the ARM only ISR attribute of accel.h dropped:
+ *    gcc -std=gnu99 -O2 -Dinterrupt= -I Sources Tests/dsp_test.c Sources/dsp.c -lm -o dsp_test && ./dsp_test
+ *  Runs a stream through Dsp_Process in blocks of random length, so the FIR history, the biquad state
+ *  and the decimator phase are carried across block boundaries, and compares it with the
+ *  stages designed in double precision (Hamming windowed sinc, bilinear Butterworth) run over the whole stream.
+ *  Exits with 0 if every sample of every chain is within DSP_TEST_TOLERANCE.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-21
+ */
+#include "dsp.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*!
+ * @brief Largest error allowed in an output sample, in counts.
+ * Covers the Q15 taps, the Q30 coefficients and the rounding to 16 bits after each stage.
+ */
+#define DSP_TEST_TOLERANCE 2.0
+
+/*!
+ * @brief Samples in the stream run through each chain.
+ */
+#define DSP_TEST_SAMPLES 6000
+
+/*!
+ * @brief Taps of DSP_STAGE_FIR_LOWPASS.
+ */
+#define DSP_TEST_FIR_TAPS 15
+
+/*!
+ * @brief A whole turn.
+ */
+#define TWO_PI 6.283185307179586
+
+/*!
+ * @brief Biquad coefficients, y = b0 x0 + b1 x1 + b2 x2 - a1 y1 - a2 y2.
+ */
+typedef struct
+{
+  double b0, b1, b2, a1, a2;
+} TReferenceBiquad;
+
+/*!
+ * @brief Design the low-pass FIR, cutoff fs / 8, with unity gain at DC.
+ * @param taps Filled with DSP_TEST_FIR_TAPS taps.
+ */
+static void DesignFir(double * const taps)
+{
+	const int middle = DSP_TEST_FIR_TAPS / 2;
+	double sum = 0.0;
+	for (int n = 0; n < DSP_TEST_FIR_TAPS; n++)
+	{
+		double sinc = (n == middle) ? 0.25 : sin(TWO_PI * (n - middle) / 8.0) / (M_PI * (n - middle));
+		taps[n] = sinc * (0.54 - 0.46 * cos(TWO_PI * n / (DSP_TEST_FIR_TAPS - 1)));
+		sum += taps[n];
+	}
+	for (int n = 0; n < DSP_TEST_FIR_TAPS; n++)
+	{
+		taps[n] /= sum;
+	}
+}
+
+/*!
+ * @brief Design a Butterworth biquad by the bilinear transform.
+ * @param cutoff The cutoff as a fraction of the sample rate.
+ * @param highpass bTRUE for a high-pass, otherwise a low-pass.
+ * @return The coefficients.
+ */
+static TReferenceBiquad DesignBiquad(const double cutoff, const BOOL highpass)
+{
+	double w0 = TWO_PI * cutoff;
+	double alpha = sin(w0) / (2.0 * M_SQRT1_2);
+	double a0 = 1.0 + alpha;
+	double c = cos(w0);
+	TReferenceBiquad biquad;
+	biquad.b1 = (highpass ? -(1.0 + c) : (1.0 - c)) / a0;
+	biquad.b0 = (highpass ? -biquad.b1 : biquad.b1) / 2.0;
+	biquad.b2 = biquad.b0;
+	biquad.a1 = -2.0 * c / a0;
+	biquad.a2 = (1.0 - alpha) / a0;
+	return biquad;
+}
+
+/*!
+ * @brief Run one stage over a whole stream of one axis.
+ * @param stage The stage.
+ * @param data The stream, filtered in place.
+ * @param count The number of samples.
+ * @return The number of samples left.
+ */
+static uint16_t ReferenceStage(const TDspStage stage, double * const data, const uint16_t count)
+{
+	static double input[DSP_TEST_SAMPLES];
+	double taps[DSP_TEST_FIR_TAPS];
+	TReferenceBiquad biquad;
+	uint16_t kept = 0;
+
+	for (uint16_t n = 0; n < count; n++)
+	{
+		input[n] = data[n];
+	}
+	switch (stage)
+	{
+	case DSP_STAGE_FIR_LOWPASS:
+		DesignFir(taps);
+		for (uint16_t n = 0; n < count; n++)
+		{
+			//The taps are symmetric, so oldest first or newest first is the same
+			data[n] = 0.0;
+			for (uint16_t k = 0; (k < DSP_TEST_FIR_TAPS) && (k <= n); k++)
+			{
+				data[n] += taps[k] * input[n - k];
+			}
+		}
+		return count;
+	case DSP_STAGE_BIQUAD_LOWPASS:
+	case DSP_STAGE_BIQUAD_HIGHPASS:
+		biquad = (stage == DSP_STAGE_BIQUAD_LOWPASS) ? DesignBiquad(1.0 / 20.0, bFALSE) : DesignBiquad(1.0 / 100.0, bTRUE);
+		for (uint16_t n = 0; n < count; n++)
+		{
+			double x1 = (n > 0) ? input[n - 1] : 0.0;
+			double x2 = (n > 1) ? input[n - 2] : 0.0;
+			double y1 = (n > 0) ? data[n - 1] : 0.0;
+			double y2 = (n > 1) ? data[n - 2] : 0.0;
+			data[n] = biquad.b0 * input[n] + biquad.b1 * x1 + biquad.b2 * x2 - biquad.a1 * y1 - biquad.a2 * y2;
+		}
+		return count;
+	case DSP_STAGE_DECIMATE_2:
+	case DSP_STAGE_DECIMATE_4:
+	{
+		uint8_t factor = (stage == DSP_STAGE_DECIMATE_2) ? 2 : 4;
+		for (uint16_t n = 0; n < count; n += factor)
+		{
+			data[kept++] = input[n];
+		}
+		return kept;
+	}
+	default:
+		return count;
+	}
+}
+
+/*!
+ * @brief Run a chain both ways and compare.
+ * @param name Printed with the result.
+ * @param stages DSP_STAGES_MAX stages.
+ * @param input The stream.
+ * @return bTRUE if every sample is within DSP_TEST_TOLERANCE.
+ */
+static BOOL Check(const char * const name, const TDspStage * const stages, const TAccelSample * const input)
+{
+	static TAccelSample output[DSP_TEST_SAMPLES];
+	static double reference[3][DSP_TEST_SAMPLES];
+	uint16_t count = 0;
+	uint16_t expected = DSP_TEST_SAMPLES;
+
+	for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+	{
+		(void) Dsp_SetStage(i, stages[i]);
+	}
+	for (uint16_t done = 0; done < DSP_TEST_SAMPLES;)
+	{
+		uint16_t block = (uint16_t) (rand() % DSP_BLOCK_MAX + 1);
+		block = (block > DSP_TEST_SAMPLES - done) ? DSP_TEST_SAMPLES - done : block;
+		count += Dsp_Process(&input[done], block, &output[count]);
+		done += block;
+	}
+
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		for (uint16_t n = 0; n < DSP_TEST_SAMPLES; n++)
+		{
+			reference[axis][n] = input[n].axes[axis];
+		}
+		expected = DSP_TEST_SAMPLES;
+		for (uint8_t i = 0; i < DSP_STAGES_MAX; i++)
+		{
+			expected = ReferenceStage(stages[i], reference[axis], expected);
+		}
+	}
+	if (count != expected)
+	{
+		printf("%-24s %u samples, expected %u FAILED\n", name, count, expected);
+		return bFALSE;
+	}
+
+	double worst = 0.0;
+	for (uint8_t axis = 0; axis < 3; axis++)
+	{
+		for (uint16_t n = 0; n < count; n++)
+		{
+			double error = fabs(output[n].axes[axis] - reference[axis][n]);
+			worst = (error > worst) ? error : worst;
+		}
+	}
+	BOOL ok = (worst <= DSP_TEST_TOLERANCE) ? bTRUE : bFALSE;
+	printf("%-24s %4u samples worst error %.2f %s\n", name, count, worst, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main(void)
+{
+	static TAccelSample input[DSP_TEST_SAMPLES];
+	const TDspStage fir[DSP_STAGES_MAX] = { DSP_STAGE_FIR_LOWPASS };
+	const TDspStage lowpass[DSP_STAGES_MAX] = { DSP_STAGE_BIQUAD_LOWPASS };
+	const TDspStage highpass[DSP_STAGES_MAX] = { DSP_STAGE_BIQUAD_HIGHPASS };
+	const TDspStage decimate[DSP_STAGES_MAX] = { DSP_STAGE_FIR_LOWPASS, DSP_STAGE_DECIMATE_4 };
+	const TDspStage chain[DSP_STAGES_MAX] = { DSP_STAGE_FIR_LOWPASS, DSP_STAGE_DECIMATE_2, DSP_STAGE_BIQUAD_HIGHPASS, DSP_STAGE_BIQUAD_LOWPASS };
+	BOOL passed = bTRUE;
+	srand(1);
+
+	//14-bit samples: tones either side of the cutoffs, noise, and gravity with a slow tone
+	for (uint16_t n = 0; n < DSP_TEST_SAMPLES; n++)
+	{
+		input[n].axes[ACCEL_X] = (int16_t) (3000.0 * sin(TWO_PI * n / 40.0) + 2000.0 * sin(TWO_PI * n / 5.0));
+		input[n].axes[ACCEL_Y] = (int16_t) (rand() % 8192 - 4096);
+		input[n].axes[ACCEL_Z] = (int16_t) (4096.0 + 1500.0 * sin(TWO_PI * n / 250.0) + 1000.0 * sin(TWO_PI * n / 9.0));
+	}
+
+	(void) Dsp_Init();
+	passed = (Check("FIR low-pass", fir, input) && passed) ? bTRUE : bFALSE;
+	passed = (Check("biquad low-pass", lowpass, input) && passed) ? bTRUE : bFALSE;
+	passed = (Check("biquad high-pass", highpass, input) && passed) ? bTRUE : bFALSE;
+	passed = (Check("FIR, decimate 4", decimate, input) && passed) ? bTRUE : bFALSE;
+	passed = (Check("FIR, decimate 2, biquads", chain, input) && passed) ? bTRUE : bFALSE;
+	return passed ? 0 : 1;
+}
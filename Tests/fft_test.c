@@ -0,0 +1,177 @@
+/*! @file
+ *
+ *  @brief Host test of the fixed-point FFT against a double precision DFT.
+ *
+ *  Not part of the tower build. From the repository root, for each radix:
+ *    gcc -std=gnu99 -O2 -I Sources -DFFT_RADIX=4 Tests/fft_test.c Sources/fft.c Sources/fixed.c -lm -o fft_test && ./fft_test
+ *    gcc -std=gnu99 -O2 -I Sources -DFFT_RADIX=2 Tests/fft_test.c Sources/fft.c Sources/fixed.c -lm -o fft_test && ./fft_test
+ *  Exits with 0 if every size is within FFT_TEST_TOLERANCE a stage, and Fft_HannWindow saturates.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-21
+ */
+#include "fft.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*!
+ * @brief Largest error allowed in a bin for each stage, in counts of the 16-bit input.
+ * Each stage truncates, so the error grows with log2 of the size.
+ */
+#define FFT_TEST_TOLERANCE 1.0
+
+/*!
+ * @brief Largest error allowed in a windowed sample, the window is truncated to 15 bits before the shift.
+ * A sample which wraps instead of saturating is out by most of the range.
+ */
+#define FFT_TEST_WINDOW_TOLERANCE 8.0
+
+/*!
+ * @brief Random frames transformed at each size.
+ */
+#define FFT_TEST_FRAMES 32
+
+/*!
+ * @brief A whole turn.
+ */
+#define TWO_PI 6.283185307179586
+
+/*!
+ * @brief Magnitudes of the DFT of a real frame, divided by its length like Fft_RealMagnitudes.
+ * @param data The samples.
+ * @param size The number of samples.
+ * @param magnitudes Filled with bins 0 to size / 2.
+ */
+static void ReferenceMagnitudes(const int16_t * const data, const uint16_t size, double * const magnitudes)
+{
+	for (uint16_t k = 0; k <= size / 2; k++)
+	{
+		double re = 0.0;
+		double im = 0.0;
+		for (uint16_t n = 0; n < size; n++)
+		{
+			double angle = TWO_PI * k * n / size;
+			re += data[n] * cos(angle);
+			im -= data[n] * sin(angle);
+		}
+		magnitudes[k] = sqrt(re * re + im * im) / size;
+	}
+}
+
+/*!
+ * @brief Transform a frame both ways and compare.
+ * @param data The samples.
+ * @param size The number of samples.
+ * @return The largest error of a bin.
+ */
+static double Compare(const int16_t * const data, const uint16_t size)
+{
+	static int16_t work[FFT_SIZE_MAX];
+	static uint16_t magnitudes[FFT_SIZE_MAX / 2 + 1];
+	static double reference[FFT_SIZE_MAX / 2 + 1];
+
+	for (uint16_t n = 0; n < size; n++)
+	{
+		work[n] = data[n];
+	}
+	if (!Fft_RealMagnitudes(work, size, magnitudes))
+	{
+		return INFINITY;
+	}
+	ReferenceMagnitudes(data, size, reference);
+
+	double worst = 0.0;
+	for (uint16_t k = 0; k <= size / 2; k++)
+	{
+		double error = fabs(magnitudes[k] - reference[k]);
+		worst = (error > worst) ? error : worst;
+	}
+	return worst;
+}
+
+/*!
+ * @brief Window frames of large samples shifted past their headroom, as spectrum.c does.
+ * @param size The number of samples.
+ * @param shift The shift given to Fft_HannWindow.
+ * @return The largest error of a windowed sample against the saturated double precision window.
+ */
+static double CompareWindow(const uint16_t size, const uint8_t shift)
+{
+	static int16_t data[FFT_SIZE_MAX];
+	static int16_t work[FFT_SIZE_MAX];
+	double worst = 0.0;
+
+	for (uint8_t run = 0; run < FFT_TEST_FRAMES; run++)
+	{
+		for (uint16_t n = 0; n < size; n++)
+		{
+			data[n] = (int16_t) (rand() % 65536 - 32768);
+			work[n] = data[n];
+		}
+		Fft_HannWindow(work, size, shift);
+		for (uint16_t n = 0; n < size; n++)
+		{
+			double w = sin(TWO_PI * n / (2 * size));
+			double expected = data[n] * (double) (1 << shift) * w * w;
+			expected = (expected > 32767.0) ? 32767.0 : ((expected < -32768.0) ? -32768.0 : expected);
+			double error = fabs(work[n] - expected);
+			worst = (error > worst) ? error : worst;
+		}
+	}
+	return worst;
+}
+
+int main(void)
+{
+	static int16_t frame[FFT_SIZE_MAX];
+	BOOL passed = bTRUE;
+	srand(1);
+
+	printf("FFT_RADIX %d\n", FFT_RADIX);
+	//FFT_SIZE_MIN is 2^4
+	for (uint16_t size = FFT_SIZE_MIN, stages = 4; size <= FFT_SIZE_MAX; size <<= 1, stages++)
+	{
+		double worst = 0.0;
+
+		//Full scale noise, the worst case for the headroom of each stage
+		for (uint8_t run = 0; run < FFT_TEST_FRAMES; run++)
+		{
+			for (uint16_t n = 0; n < size; n++)
+			{
+				frame[n] = (int16_t) (rand() % 65536 - 32768);
+			}
+			double error = Compare(frame, size);
+			worst = (error > worst) ? error : worst;
+		}
+
+		//Two tones and an offset, on and between bins
+		for (uint8_t run = 0; run < FFT_TEST_FRAMES; run++)
+		{
+			double bin = (double) (rand() % (size * 4)) / 8.0;
+			for (uint16_t n = 0; n < size; n++)
+			{
+				frame[n] = (int16_t) (12000.0 * sin(TWO_PI * bin * n / size) + 6000.0 * cos(TWO_PI * (size / 4) * n / size) - 2000.0);
+			}
+			double error = Compare(frame, size);
+			worst = (error > worst) ? error : worst;
+		}
+
+		BOOL ok = (worst <= FFT_TEST_TOLERANCE * stages) ? bTRUE : bFALSE;
+		printf("size %4u worst bin error %.2f %s\n", size, worst, ok ? "ok" : "FAILED");
+		passed = (passed && ok) ? bTRUE : bFALSE;
+	}
+
+	double window = CompareWindow(FFT_SIZE_MAX, 2);
+	BOOL windowOk = (window <= FFT_TEST_WINDOW_TOLERANCE) ? bTRUE : bFALSE;
+	printf("window shift 2 worst sample error %.2f %s\n", window, windowOk ? "ok" : "FAILED");
+	passed = (passed && windowOk) ? bTRUE : bFALSE;
+
+	if (Fft_RealMagnitudes(frame, FFT_SIZE_MIN / 2, (uint16_t *) frame) || Fft_RealMagnitudes(frame, 48, (uint16_t *) frame))
+	{
+		printf("invalid size accepted FAILED\n");
+		passed = bFALSE;
+	}
+	return passed ? 0 : 1;
+}
@@ -0,0 +1,179 @@
+/*! @file
+ *
+ *  @brief Host check and benchmark of the streaming median filter.
+ *
+ *  Not part of the tower build, BENCH_MEDIAN measures the tower. From the repository root:
+ *    gcc -std=gnu99 -O2 -I Sources Tests/median_bench.c Sources/median.c -o median_bench && ./median_bench
+ *  Checks Median_Update against sorting the window for every window length and
+ *  Median_Filter3Packed (the portable version, not SSUB16/SEL) against Median_Filter3Int16,
+ *  then times Median_Update against insertion sorting a copy of the window as BENCH_MEDIAN does.
+ *  Exits with 0 if every median matched.
+ *
+ *  @author Robin Wohlers-Reichel, Joshua Gonsalves
+ *  @date 2016-07-21
+ */
+#include "median.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*!
+ * @brief Values checked for each window length.
+ */
+#define MEDIAN_CHECK_UPDATES 5000
+
+/*!
+ * @brief Values timed for each window length.
+ */
+#define MEDIAN_BENCH_UPDATES 2000000
+
+/*!
+ * @brief Window lengths timed, as BENCH_MEDIAN_WINDOWS.
+ */
+#define MEDIAN_BENCH_WINDOWS { 3, 15, 63 }
+
+/*!
+ * @brief Median of a window by insertion sorting a copy, as bench.c SortMedian does for odd lengths.
+ * @param window The values.
+ * @param length The number of values.
+ * @return The median, the mean of the middle two for an even length.
+ */
+static int16_t SortMedian(const int16_t * const window, const uint8_t length)
+{
+	int16_t sorted[MEDIAN_WINDOW_MAX];
+	memcpy(sorted, window, length * sizeof(sorted[0]));
+	for (uint8_t i = 1; i < length; i++)
+	{
+		int16_t value = sorted[i];
+		uint8_t j = i;
+		for (; (j > 0) && (sorted[j - 1] > value); j--)
+		{
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = value;
+	}
+	if (length & 1)
+	{
+		return sorted[length / 2];
+	}
+	return (int16_t) (((int32_t) sorted[length / 2 - 1] + sorted[length / 2]) / 2);
+}
+
+/*!
+ * @brief Check every update of one window length against SortMedian.
+ * @param length The window length.
+ * @return bTRUE if every median matched.
+ */
+static BOOL Check(const uint8_t length)
+{
+	TMedianFilter filter;
+	int16_t window[MEDIAN_WINDOW_MAX];
+	uint8_t count = 0;
+	uint8_t next = 0;
+
+	if (!Median_Init(&filter, length))
+	{
+		printf("window %u init FAILED\n", length);
+		return bFALSE;
+	}
+	for (uint32_t i = 0; i < MEDIAN_CHECK_UPDATES; i++)
+	{
+		//Plenty of repeated values, to exercise ties
+		int16_t value = (rand() % 3 == 0) ? (int16_t) (rand() % 5) : (int16_t) (rand() % 16384 - 8192);
+		int16_t median = Median_Update(&filter, value);
+		window[next] = value;
+		next = (next + 1 == length) ? 0 : next + 1;
+		count = (count < length) ? count + 1 : count;
+		int16_t expected = SortMedian(window, count);
+		if (median != expected)
+		{
+			printf("window %u update %lu got %d expected %d FAILED\n", length, (unsigned long) i, median, expected);
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Check Median_Filter3Packed against Median_Filter3Int16 on each half.
+ * @return bTRUE if every median matched.
+ */
+static BOOL CheckPacked()
+{
+	for (uint32_t i = 0; i < MEDIAN_CHECK_UPDATES; i++)
+	{
+		int16_t lo[3];
+		int16_t hi[3];
+		uint32_t packed[3];
+		for (uint8_t n = 0; n < 3; n++)
+		{
+			lo[n] = (int16_t) rand();
+			hi[n] = (int16_t) rand();
+			packed[n] = (uint16_t) lo[n] | ((uint32_t) (uint16_t) hi[n] << 16);
+		}
+		uint32_t median = Median_Filter3Packed(packed[0], packed[1], packed[2]);
+		if (((int16_t) median != Median_Filter3Int16(lo[0], lo[1], lo[2]))
+				|| ((int16_t) (median >> 16) != Median_Filter3Int16(hi[0], hi[1], hi[2])))
+		{
+			printf("packed median of 3 FAILED\n");
+			return bFALSE;
+		}
+	}
+	return bTRUE;
+}
+
+/*!
+ * @brief Time both ways of taking the median over one window length.
+ * @param length The window length.
+ */
+static void Bench(const uint8_t length)
+{
+	TMedianFilter filter;
+	int16_t window[MEDIAN_WINDOW_MAX] = { 0 };
+	uint8_t next = 0;
+	volatile int16_t median;
+
+	(void) Median_Init(&filter, length);
+	clock_t start = clock();
+	for (uint32_t i = 0; i < MEDIAN_BENCH_UPDATES; i++)
+	{
+		median = Median_Update(&filter, (int16_t) rand());
+	}
+	double streaming = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+	start = clock();
+	for (uint32_t i = 0; i < MEDIAN_BENCH_UPDATES; i++)
+	{
+		window[next] = (int16_t) rand();
+		next = (next + 1 == length) ? 0 : next + 1;
+		median = SortMedian(window, length);
+	}
+	double sort = (double) (clock() - start) / CLOCKS_PER_SEC;
+	(void) median;
+
+	//Both include rand()
+	printf("window %2u streaming %6.1f ns sort %6.1f ns per update\n", length,
+			streaming * 1e9 / MEDIAN_BENCH_UPDATES, sort * 1e9 / MEDIAN_BENCH_UPDATES);
+}
+
+int main(void)
+{
+	const uint8_t windows[] = MEDIAN_BENCH_WINDOWS;
+	BOOL passed = bTRUE;
+	srand(1);
+
+	for (uint8_t length = MEDIAN_WINDOW_MIN; length <= MEDIAN_WINDOW_MAX; length++)
+	{
+		passed = (Check(length) && passed) ? bTRUE : bFALSE;
+	}
+	printf("windows %u to %u %s\n", MEDIAN_WINDOW_MIN, MEDIAN_WINDOW_MAX, passed ? "ok" : "FAILED");
+	passed = (CheckPacked() && passed) ? bTRUE : bFALSE;
+
+	for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++)
+	{
+		Bench(windows[w]);
+	}
+	return passed ? 0 : 1;
+}